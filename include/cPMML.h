@@ -7,10 +7,16 @@
 #ifndef CPMML_CPMML_H
 #define CPMML_CPMML_H
 
+#include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace cpmml {
 /**
@@ -19,6 +25,25 @@ namespace cpmml {
  */
 extern const std::string version;
 
+/**
+ * @brief It returns the number of threads, the calling one included, among
+ * which the segments of a large ensemble are split while scoring a sample.
+ */
+size_t num_threads();
+
+/**
+ * @brief It sets the number of threads, the calling one included, among which
+ * the segments of a large ensemble are split while scoring a sample.
+ *
+ * The threads are started once and shared by all models. Only ensembles whose
+ * segments are expensive enough to be worth the synchronization are split,
+ * and the result of the scoring doesn't depend on the number of threads. The
+ * default is the value of THREADS given when building cPMML; with 1, or
+ * without multithreading support, samples are scored by the calling thread
+ * alone.
+ */
+void set_num_threads(const size_t n_threads);
+
 /**
  * @class Exception
  * @brief Base class for all exceptions generated by cPMML.
@@ -111,6 +136,78 @@ class ParsingException : public Exception {
    */
   explicit ParsingException(const std::string &message);
 };
+
+/**
+ * @class Status
+ * @brief Outcome of a scoring performed through cpmml::Model::try_score or
+ * cpmml::Model::try_predict.
+ *
+ * It reports the same errors as the exceptions thrown by cpmml::Model::score,
+ * without the cost of throwing them: the explanatory message is only built
+ * when cpmml::Status::message is called.
+ */
+class Status {
+ public:
+  /**
+   * @brief Kind of error.
+   */
+  enum class Code : uint8_t {
+    OK,             // scoring succeeded
+    INVALID_VALUE,  // a field didn't pass input validation, see cpmml::InvalidValueException
+    MISSING_VALUE,  // a field needed by the model is missing, see cpmml::MissingValueException
+    MATH_ERROR,     // see cpmml::MathException
+    ERROR           // any other cpmml::Exception
+  };
+
+  Status() = default;
+
+  /**
+   * @brief Constructs a cpmml::Status reporting an error on a field.
+   *
+   * @param code kind of error.
+   * @param field handle of the field, as returned by cpmml::Model::get_handle.
+   * @param field_name name of the field, copied so that the status can outlive
+   * the model.
+   */
+  Status(const Code code, const size_t field, const std::string &field_name);
+
+  /**
+   * @brief Constructs a cpmml::Status reporting an error not bound to a field.
+   *
+   * @param code kind of error.
+   * @param message explanatory string providing more details about the error.
+   */
+  Status(const Code code, const std::string &message);
+
+  /**
+   * @return *true* when the scoring succeeded.
+   */
+  bool ok() const;
+
+  /**
+   * @return the kind of error.
+   */
+  Code code() const;
+
+  /**
+   * @return the handle of the field which caused the error, as returned by
+   * cpmml::Model::get_handle. <a
+   * href="https://en.cppreference.com/w/cpp/types/numeric_limits/max">std::numeric_limits<size_t>::max()</a>
+   * if the error is not bound to a field.
+   */
+  size_t field() const;
+
+  /**
+   * @return an explanatory string providing more details about the error.
+   */
+  std::string message() const;
+
+ private:
+  Code status_code = Code::OK;
+  size_t field_handle = static_cast<size_t>(-1);
+  std::string field_name;  // empty if the error is not bound to a field
+  std::string details;
+};
 }  // namespace cpmml
 
 class InternalScore;
@@ -212,17 +309,309 @@ class Prediction {
    */
   std::unordered_map<std::string, std::string> str_outputs() const;
 
+  /**
+   * @brief It returns the target categories known to the model, without
+   * copying them. They are shared by all the predictions of the model.
+   */
+  const std::vector<std::string> &labels() const;
+
+  /**
+   * @brief It returns the probabilities computed by the model, without copying
+   * them. Each probability refers to the target category at the same position
+   * of labels(): categories with no probability, as well as the ones beyond the
+   * end of the vector, hold <a
+   * href="https://en.cppreference.com/w/cpp/types/numeric_limits/min">std::numeric_limits<double>::min()</a>.
+   */
+  const std::vector<double> &probabilities() const;
+
+  /**
+   * @brief It returns the k most probable target categories, in decreasing
+   * order of probability. Each pair holds the position of the category in
+   * labels() and its probability.
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * cpmml::Prediction prediction = model.score(sample);
+   * for (const auto &top : prediction.top_k(2))
+   *    std::cout << prediction.labels()[top.first] << ": " << top.second <<
+   * std::endl;
+   *
+   * // "Iris-versicolor: 0.918919"
+   * // "Iris-virginica: 0.0810811"
+   * @endcode
+   */
+  std::vector<std::pair<size_t, double>> top_k(const size_t k) const;
+
+  /**
+   * @brief It returns the names of the numeric output fields, without copying
+   * them. See num_output_values().
+   */
+  const std::vector<std::string> &num_output_names() const;
+
+  /**
+   * @brief It returns the values of the numeric output fields, in the order of
+   * num_output_names(), without copying them.
+   */
+  const std::vector<double> &num_output_values() const;
+
+  /**
+   * @brief It returns the names of the categorical output fields, without
+   * copying them. See str_output_values().
+   */
+  const std::vector<std::string> &str_output_names() const;
+
+  /**
+   * @brief It returns the values of the categorical output fields, in the order
+   * of str_output_names(), without copying them.
+   */
+  const std::vector<std::string> &str_output_values() const;
+
  private:
   std::shared_ptr<InternalScore> score;
 };
 }  // namespace cpmml
 
+namespace cpmml {
+
+/**
+ * @class Batch
+ * @brief Class representing a block of samples stored column by column.
+ *
+ * It is the input of cpmml::Model::score_batch. Rather than one hash map per
+ * sample, each feature is provided through a contiguous buffer holding its
+ * values for all the samples of the block:
+ * - numeric features as an array of doubles, along with an optional bitmap
+ *   flagging missing values;
+ * - categorical features as an array of integer codes, along with the
+ *   dictionary translating each code into the corresponding category.
+ *
+ * Features not provided are treated as missing values, while columns not used
+ * by the model are ignored.<br>
+ *
+ * A Batch does not own the buffers it refers to: they must stay valid until
+ * the scoring is over.
+ */
+class Batch {
+ public:
+  /**
+   * @brief Column holding the values of a numeric feature.
+   */
+  struct NumericColumn {
+    std::string name;
+    const double *values;
+    const uint8_t *missing;
+  };
+
+  /**
+   * @brief Column holding the dictionary-coded values of a categorical
+   * feature.
+   */
+  struct CategoricalColumn {
+    std::string name;
+    const int32_t *codes;
+    std::vector<std::string> dictionary;
+  };
+
+  Batch() = default;
+
+  /**
+   * @brief Constructs an empty cpmml::Batch for *n_rows* samples.
+   *
+   * @param n_rows number of samples in the block.
+   */
+  explicit Batch(const size_t n_rows);
+
+  /**
+   * @brief Adds a numeric feature to the block.
+   *
+   * @param name feature name.
+   * @param values array of *n_rows* values.
+   * @param missing *(optional)* bitmap of *(n_rows + 7) / 8* bytes, where bit
+   * *i % 8* of byte *i / 8* is set when the value of the sample *i* is missing.
+   * The default value is *nullptr*, meaning no value is missing.
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * std::vector<double> sepal_length = {6.6, 5.1, 7.2};
+   * uint8_t missing = 0x02; // sepal_length is missing for the second sample
+   *
+   * cpmml::Batch batch(3);
+   * batch.add_numeric("sepal_length", sepal_length.data(), &missing);
+   * @endcode
+   */
+  void add_numeric(const std::string &name, const double *values, const uint8_t *missing = nullptr);
+
+  /**
+   * @brief Adds a categorical feature to the block.
+   *
+   * @param name feature name.
+   * @param codes array of *n_rows* codes, each of them indexing *dictionary*. A
+   * negative code signals a missing value.
+   * @param dictionary categories referenced by *codes*.
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * std::vector<int32_t> employment = {0, 1, -1, 0};
+   *
+   * cpmml::Batch batch(4);
+   * batch.add_categorical("Employment", employment.data(), {"Private", "Consultant"});
+   * @endcode
+   */
+  void add_categorical(const std::string &name, const int32_t *codes, const std::vector<std::string> &dictionary);
+
+  /**
+   * @return the number of samples in the block.
+   */
+  size_t size() const;
+
+  /**
+   * @return the numeric features in the block.
+   */
+  const std::vector<NumericColumn> &numeric_columns() const;
+
+  /**
+   * @return the categorical features in the block.
+   */
+  const std::vector<CategoricalColumn> &categorical_columns() const;
+
+ private:
+  size_t n_rows = 0;
+  std::vector<NumericColumn> numerics;
+  std::vector<CategoricalColumn> categoricals;
+};
+}  // namespace cpmml
+
+namespace cpmml {
+
+/**
+ * @class Input
+ * @brief Class representing a single sample, whose features are addressed
+ * through handles rather than through their names.
+ *
+ * Handles are obtained once, through cpmml::Model::get_handle, so that no
+ * feature name is hashed while scoring. An Input is meant to be reused across
+ * requests: setting a value does not allocate memory once the Input has been
+ * filled the first time.<br>
+ *
+ * Features never set, or set through cpmml::Input::set_missing, are treated as
+ * missing values.
+ */
+class Input {
+ public:
+  /**
+   * @brief Kind of the value held by a feature.
+   */
+  enum class Kind : uint8_t { MISSING, NUMERIC, STRING };
+
+  /**
+   * @brief Value of a feature.
+   */
+  struct Field {
+    Kind kind = Kind::MISSING;
+    double number = 0;
+    std::string string;
+  };
+
+  Input() = default;
+
+  /**
+   * @brief Sets a numeric value for the feature identified by *handle*.
+   *
+   * @param handle handle obtained through cpmml::Model::get_handle.
+   * @param value feature value.
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * cpmml::Model model("IrisTree.xml");
+   * const size_t sepal_length = model.get_handle("sepal_length");
+   *
+   * cpmml::Input input;
+   * input.set(sepal_length, 6.6);
+   * @endcode
+   */
+  void set(const size_t handle, const double value);
+
+  /**
+   * @brief Sets a value, expressed as a string, for the feature identified by
+   * *handle*.
+   *
+   * @param handle handle obtained through cpmml::Model::get_handle.
+   * @param value feature value.
+   */
+  void set(const size_t handle, const std::string &value);
+
+  /**
+   * @brief Flags as missing the feature identified by *handle*.
+   *
+   * @param handle handle obtained through cpmml::Model::get_handle.
+   */
+  void set_missing(const size_t handle);
+
+  /**
+   * @brief Flags as missing all features, keeping the memory already
+   * allocated.
+   */
+  void clear();
+
+  /**
+   * @return the values of the features, indexed by handle.
+   */
+  const std::vector<Field> &fields() const;
+
+ private:
+  std::vector<Field> values;
+
+  Field &at(const size_t handle);
+};
+}  // namespace cpmml
+
+class InternalContext;
+namespace cpmml {
+
+/**
+ * @class ScoringContext
+ * @brief Class holding the memory used to score a sample.
+ *
+ * Passing a ScoringContext to cpmml::Model::score or cpmml::Model::predict
+ * allows to reuse the same working memory across scorings: it is reset rather
+ * than reallocated, so that scoring in steady state does not hit the heap.<br>
+ *
+ * This holds for trees, regressions, sums of regression trees and the
+ * transformations they rely on. Other ensembles (e.g. Gradient Boosted Trees
+ * or Random Forest classifiers) still allocate, for each sample, the votes or
+ * the intermediate samples and scores of their segments.<br>
+ *
+ * A ScoringContext is not thread-safe: each thread is meant to own its
+ * context. It can be used with any model, though it is most effective when
+ * always used with the same one.
+ */
+class ScoringContext {
+ public:
+  ScoringContext();
+
+ private:
+  friend class Model;
+  std::shared_ptr<InternalContext> context;
+};
+}  // namespace cpmml
+
 class InternalEvaluator;
+class AsyncScorer;
 namespace cpmml {
 
 /**
  *  @class  Model
  *  @brief  Class representing a PMML model.
+ *
+ *  Once loaded, a model is never modified by scoring: all its const methods
+ *  can be called concurrently from any number of threads, with no
+ *  synchronization. The scratch memory of a scoring is owned by the calling
+ *  thread, or by the cpmml::ScoringContext it provides, which must not be
+ *  shared between threads.
  */
 class Model {
  public:
@@ -268,6 +657,25 @@ class Model {
    */
   Model(const std::string &model_filepath, const bool zipped);
 
+  /**
+   * @brief Loads the model from the *size* bytes at *data*, holding a PMML
+   * document, zipped if *zipped* is true.
+   *
+   * <p>
+   * It allows to load models which are not in a file, as ones fetched from
+   * the network, without writing them to a temporary file. The buffer is only
+   * read, and it can be released as soon as the constructor returns.<br></p>
+   *
+   *
+   * @param data PMML document, or zip archive whose first file is the PMML
+   * document.
+   * @param size number of bytes at *data*.
+   * @param zipped whether *data* is a zip archive.
+   *
+   * @throws cpmml::ParsingException
+   */
+  Model(const char *data, const size_t size, const bool zipped);
+
   /**
    * @brief Validates user input in *sample* against the constraints defined in
    * the <a href="http://dmg.org/pmml/v4-4/DataDictionary.html">PMML
@@ -381,8 +789,481 @@ class Model {
    */
   std::string predict(const std::unordered_map<std::string, std::string> &sample) const;
 
+  /**
+   * @brief Scores the model against all the samples in *batch*.
+   *
+   * <p>
+   * It is equivalent to calling cpmml::Model::predict for each sample of the
+   * block, but the input is read straight from the column buffers: no hash map
+   * is built and no numeric value is parsed from a string. Categorical values
+   * are converted once per dictionary entry rather than once per sample.<br>
+   *
+   * The predictions are written in the same order as the samples.<br>
+   *
+   * Regression models score the samples of a block through a matrix
+   * multiplication, which sums the terms of the regression in another order
+   * than the scoring of a single sample: numeric predictions may differ from
+   * the ones of cpmml::Model::predict in the last bits, and a classification
+   * whose best scores are that close may pick the other class.<br></p>
+   *
+   *
+   * @param batch block of samples to be scored.
+   * @param predictions caller-owned array of at least *batch.size()* strings,
+   * receiving the predicted values.
+   *
+   * @throws cpmml::InvalidValueException
+   * @throws cpmml::MissingValueException
+   * @throws cpmml::MathException
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * cpmml::Model model("IrisTree.xml");
+   * std::vector<double> sepal_length = {6.6, 5.1}, sepal_width = {2.9, 3.5};
+   * std::vector<double> petal_length = {4.6, 1.4}, petal_width = {1.3, 0.2};
+   *
+   * cpmml::Batch batch(2);
+   * batch.add_numeric("sepal_length", sepal_length.data());
+   * batch.add_numeric("sepal_width", sepal_width.data());
+   * batch.add_numeric("petal_length", petal_length.data());
+   * batch.add_numeric("petal_width", petal_width.data());
+   *
+   * std::vector<std::string> predictions(batch.size());
+   * model.score_batch(batch, predictions.data()); // {"Iris-versicolor", "Iris-setosa"}
+   * @endcode
+   */
+  void score_batch(const Batch &batch, std::string *predictions) const;
+
+  /**
+   * @brief Scores the model against all the samples in *batch*, returning the
+   * predicted values as doubles.
+   *
+   * <p>
+   * As the previous one, but the predictions are doubles, as returned by
+   * cpmml::Model::predict_double up to the last bits.<br></p>
+   *
+   *
+   * @param batch block of samples to be scored.
+   * @param predictions caller-owned array of at least *batch.size()* doubles,
+   * receiving the predicted values.
+   *
+   * @throws cpmml::InvalidValueException
+   * @throws cpmml::MissingValueException
+   * @throws cpmml::MathException
+   */
+  void score_batch(const Batch &batch, double *predictions) const;
+
+  /**
+   * @brief Scores the model against all the samples in *batch*, split among
+   * *n_threads* threads.
+   *
+   * <p>
+   * As cpmml::Model::score_batch, but the blocks of samples of the batch are
+   * scored in parallel: each thread starts from its own share of the batch and,
+   * when it is over, takes over part of the share of a thread still busy. Every
+   * thread has its own scratch samples and buffers, and writes to its own slots
+   * of *predictions*, so the predictions are the same as the ones of
+   * cpmml::Model::score_batch.<br>
+   * The threads are started for this call and joined before it returns. While
+   * they run, the segments of ensembles are not split among threads (see
+   * cpmml::set_num_threads). Without multithreading support the batch is scored
+   * by the calling thread alone.<br></p>
+   *
+   *
+   * @param batch block of samples to be scored.
+   * @param predictions caller-owned array of at least *batch.size()* strings,
+   * receiving the predicted values.
+   * @param n_threads number of threads, the calling one included; 0 means as
+   * many as the hardware supports.
+   *
+   * @throws cpmml::InvalidValueException
+   * @throws cpmml::MissingValueException
+   * @throws cpmml::MathException
+   */
+  void score_batch_parallel(const Batch &batch, std::string *predictions, const size_t n_threads = 0) const;
+
+  /**
+   * @brief Scores the model against all the samples in *batch*, split among
+   * *n_threads* threads, returning the predicted values as doubles.
+   *
+   * <p>
+   * As the previous one, but the predictions are doubles, as returned by
+   * cpmml::Model::predict_double.<br></p>
+   *
+   *
+   * @param batch block of samples to be scored.
+   * @param predictions caller-owned array of at least *batch.size()* doubles,
+   * receiving the predicted values.
+   * @param n_threads number of threads, the calling one included; 0 means as
+   * many as the hardware supports.
+   *
+   * @throws cpmml::InvalidValueException
+   * @throws cpmml::MissingValueException
+   * @throws cpmml::MathException
+   */
+  void score_batch_parallel(const Batch &batch, double *predictions, const size_t n_threads = 0) const;
+
+  /**
+   * @brief Resolves the feature *name* to the handle used to address it in a
+   * cpmml::Input.
+   *
+   * <p>
+   * Handles are stable for the whole life of the model, so they are meant to
+   * be resolved once, for instance when the application starts.<br></p>
+   *
+   *
+   * @param name feature name.
+   * @return the handle of the feature.
+   *
+   * @throws cpmml::InvalidValueException in case the model does not define a
+   * feature named *name*.
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * cpmml::Model model("IrisTree.xml");
+   * const size_t sepal_length = model.get_handle("sepal_length");
+   * const size_t sepal_width = model.get_handle("sepal_width");
+   * @endcode
+   */
+  size_t get_handle(const std::string &name) const;
+
+  /**
+   * @brief As cpmml::Model::validate, but the sample is read from a
+   * cpmml::Input.
+   *
+   * @param input sample to be validated.
+   * @return *true* in case of valid *input*.  *false* otherwise.
+   */
+  bool validate(const Input &input) const;
+
+  /**
+   * @brief As cpmml::Model::score, but the sample is read from a cpmml::Input.
+   *
+   * @param input sample to be scored.
+   * @return cpmml::Prediction representing the score.
+   *
+   * @throws cpmml::InvalidValueException
+   * @throws cpmml::MissingValueException
+   * @throws cpmml::MathException
+   */
+  Prediction score(const Input &input) const;
+
+  /**
+   * @brief As cpmml::Model::predict, but the sample is read from a
+   * cpmml::Input.
+   *
+   * @param input sample to be scored.
+   * @return predicted value as a string.
+   *
+   * @throws cpmml::InvalidValueException
+   * @throws cpmml::MissingValueException
+   * @throws cpmml::MathException
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * cpmml::Model model("IrisTree.xml");
+   * const size_t sepal_length = model.get_handle("sepal_length");
+   * const size_t sepal_width = model.get_handle("sepal_width");
+   * const size_t petal_length = model.get_handle("petal_length");
+   * const size_t petal_width = model.get_handle("petal_width");
+   *
+   * cpmml::Input input;
+   * input.set(sepal_length, 6.6);
+   * input.set(sepal_width, 2.9);
+   * input.set(petal_length, 4.6);
+   * input.set(petal_width, 1.3);
+   *
+   * std::cout << model.predict(input) << std::endl;
+   * @endcode
+   */
+  std::string predict(const Input &input) const;
+
+  /**
+   * @brief As cpmml::Model::score, but the scoring is performed within the
+   * memory owned by *context*.
+   *
+   * <p>
+   * The cpmml::Prediction returned refers to the memory of *context*: it is
+   * valid until *context* is used for the next scoring.<br></p>
+   *
+   *
+   * @param input sample to be scored.
+   * @param context scratch memory reused across scorings.
+   * @return cpmml::Prediction representing the score.
+   *
+   * @throws cpmml::InvalidValueException
+   * @throws cpmml::MissingValueException
+   * @throws cpmml::MathException
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * cpmml::Model model("IrisTree.xml");
+   * cpmml::ScoringContext context;  // one per thread
+   * cpmml::Input input;
+   * ...
+   * cpmml::Prediction prediction = model.score(input, context);
+   * @endcode
+   */
+  Prediction score(const Input &input, ScoringContext &context) const;
+
+  /**
+   * @brief As cpmml::Model::predict, but the scoring is performed within the
+   * memory owned by *context*.
+   *
+   * @param input sample to be scored.
+   * @param context scratch memory reused across scorings.
+   * @return predicted value as a string, owned by *context*: it is valid until
+   * *context* is used for the next scoring.
+   *
+   * @throws cpmml::InvalidValueException
+   * @throws cpmml::MissingValueException
+   * @throws cpmml::MathException
+   */
+  const std::string &predict(const Input &input, ScoringContext &context) const;
+
+  /**
+   * @brief Scores the model against *sample*, returning the prediction as a
+   * double.
+   *
+   * <p>
+   * For regression models the predicted value flows as a double from the model
+   * to the returned value: it is never formatted as a string, hence it is not
+   * rounded as the one returned by cpmml::Model::predict.<br>
+   *
+   * For classification models it is the predicted class converted to double.
+   * In case it cannot be converted, <a
+   * href="https://en.cppreference.com/w/cpp/types/numeric_limits/min">std::numeric_limits<double>::min()</a>
+   * is returned.<br></p>
+   *
+   *
+   * @param sample hash map where the keys are strings representing feature
+   * names and the values are strings representing features values.
+   * @return predicted value as a double.
+   *
+   * @throws cpmml::InvalidValueException
+   * @throws cpmml::MissingValueException
+   * @throws cpmml::MathException
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * cpmml::Model model("IrisLinearReg.xml");
+   * std::unordered_map<std::string, std::string> sample = {
+   *   {"sepal_length", "6.6"},
+   *   {"sepal_width", "2.9"},
+   *   {"petal_length", "4.6"}
+   * };
+   *
+   * double petal_width = model.predict_double(sample);
+   * @endcode
+   */
+  double predict_double(const std::unordered_map<std::string, std::string> &sample) const;
+
+  /**
+   * @brief As the previous one, but the sample is read from a cpmml::Input.
+   */
+  double predict_double(const Input &input) const;
+
+  /**
+   * @brief As the previous one, but the scoring is performed within the memory
+   * owned by *context*.
+   */
+  double predict_double(const Input &input, ScoringContext &context) const;
+
+  /**
+   * @brief Scores a classification model against *sample*, returning the
+   * predicted class as an index of cpmml::Model::classes.
+   *
+   * <p>
+   * No string is built nor compared while scoring: the class is translated to
+   * its name only if the caller looks it up in cpmml::Model::classes.<br></p>
+   *
+   *
+   * @param sample hash map where the keys are strings representing feature
+   * names and the values are strings representing features values.
+   * @return index of the predicted class in cpmml::Model::classes. -1 in case
+   * no class is predicted.
+   *
+   * @throws cpmml::Exception in case the model is not a classification model.
+   * @throws cpmml::InvalidValueException
+   * @throws cpmml::MissingValueException
+   * @throws cpmml::MathException
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * cpmml::Model model("IrisTree.xml");
+   * std::unordered_map<std::string, std::string> sample = {
+   *   {"sepal_length", "6.6"},
+   *   {"sepal_width", "2.9"},
+   *   {"petal_length", "4.6"},
+   *   {"petal_width", "1.3"}
+   * };
+   *
+   * int predicted = model.predict_class_index(sample);
+   * if (predicted >= 0) std::cout << model.classes()[predicted] << std::endl;
+   * @endcode
+   */
+  int predict_class_index(const std::unordered_map<std::string, std::string> &sample) const;
+
+  /**
+   * @brief As the previous one, but the sample is read from a cpmml::Input.
+   */
+  int predict_class_index(const Input &input) const;
+
+  /**
+   * @brief As the previous one, but the scoring is performed within the memory
+   * owned by *context*.
+   */
+  int predict_class_index(const Input &input, ScoringContext &context) const;
+
+  /**
+   * @brief Returns the classes a classification model can predict.
+   *
+   * @return the class table, indexed by the values returned by
+   * cpmml::Model::predict_class_index. Each class is represented as returned by
+   * cpmml::Model::predict. It is empty for regression models.
+   */
+  const std::vector<std::string> &classes() const;
+
+  /**
+   * @brief As cpmml::Model::score, but errors are reported through the
+   * returned cpmml::Status rather than with exceptions.
+   *
+   * <p>
+   * Samples not passing input validation are detected without throwing nor
+   * building any message: it is meant for workloads where a share of the
+   * samples is expected to be invalid.<br></p>
+   *
+   *
+   * @param sample hash map where the keys are strings representing feature
+   * names and the values are strings representing features values.
+   * @param prediction receives the cpmml::Prediction when the scoring succeeds,
+   * it is left untouched otherwise.
+   * @return the outcome of the scoring.
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * cpmml::Model model("IrisTree.xml");
+   * cpmml::Prediction prediction;
+   *
+   * cpmml::Status status = model.try_score(sample, prediction);
+   * if (!status.ok()) std::cerr << status.message() << std::endl;
+   * @endcode
+   */
+  Status try_score(const std::unordered_map<std::string, std::string> &sample, Prediction &prediction) const;
+
+  /**
+   * @brief As the previous one, but the sample is read from a cpmml::Input.
+   */
+  Status try_score(const Input &input, Prediction &prediction) const;
+
+  /**
+   * @brief As cpmml::Model::predict, but errors are reported through the
+   * returned cpmml::Status rather than with exceptions.
+   *
+   * @param sample hash map where the keys are strings representing feature
+   * names and the values are strings representing features values.
+   * @param prediction receives the predicted value when the scoring succeeds,
+   * it is left untouched otherwise.
+   * @return the outcome of the scoring.
+   */
+  Status try_predict(const std::unordered_map<std::string, std::string> &sample, std::string &prediction) const;
+
+  /**
+   * @brief As the previous one, but the sample is read from a cpmml::Input.
+   */
+  Status try_predict(const Input &input, std::string &prediction) const;
+
+  /**
+   * @brief As the previous one, but the scoring is performed within the memory
+   * owned by *context*.
+   */
+  Status try_predict(const Input &input, ScoringContext &context, std::string &prediction) const;
+
+  /**
+   * @brief Submits *input* to be scored in the background, returning a future
+   * receiving the cpmml::Prediction.
+   *
+   * <p>
+   * The input is copied, and the call returns as soon as it is queued: it
+   * never waits for a lock nor for the scoring. The requests are scored by
+   * worker threads owned by the model, started with the first request, which
+   * take queued requests in groups and predict together the ones submitted
+   * through cpmml::Model::predict_async, as cpmml::Model::score_batch does.
+   * When the queue is full, or without multithreading support, the input is
+   * scored by the calling thread before returning.<br>
+   * Errors are reported through the future, with the same exceptions as
+   * cpmml::Model::score. Copies of the model share the same workers, which
+   * complete all the pending requests before the last copy is
+   * destroyed.<br></p>
+   *
+   *
+   * @param input sample to be scored.
+   * @return the future cpmml::Prediction.
+   *
+   *
+   * <br><p><b>Examples</b></p>
+   * @code{.cpp}
+   * cpmml::Model model("IrisTree.xml");
+   * std::future<cpmml::Prediction> prediction = model.score_async(input);
+   * ...
+   * prediction.get().as_string(); // "Iris-versicolor"
+   * @endcode
+   */
+  std::future<Prediction> score_async(const Input &input) const;
+
+  /**
+   * @brief As the previous one, but the result is handed to *callback*, along
+   * with the cpmml::Status of the scoring as returned by
+   * cpmml::Model::try_score.
+   *
+   * <p>
+   * The callback is run by a worker thread, so it should be short and it
+   * should not wait for other requests. Exceptions thrown by the callback are
+   * ignored.<br></p>
+   *
+   *
+   * @param input sample to be scored.
+   * @param callback function receiving the outcome of the scoring and, when
+   * it succeeded, the cpmml::Prediction.
+   */
+  void score_async(const Input &input, const std::function<void(const Status &, const Prediction &)> &callback) const;
+
+  /**
+   * @brief As cpmml::Model::score_async, but only the predicted value is
+   * returned, as by cpmml::Model::predict.
+   *
+   * <p>
+   * Prediction requests queued together are predicted as a block of
+   * samples.<br></p>
+   *
+   *
+   * @param input sample to be scored.
+   * @return the future predicted value.
+   */
+  std::future<std::string> predict_async(const Input &input) const;
+
+  /**
+   * @brief As the previous one, but the result is handed to *callback*, along
+   * with the cpmml::Status of the scoring as returned by
+   * cpmml::Model::try_predict.
+   *
+   *
+   * @param input sample to be scored.
+   * @param callback function receiving the outcome of the scoring and, when
+   * it succeeded, the predicted value.
+   */
+  void predict_async(const Input &input,
+                     const std::function<void(const Status &, const std::string &)> &callback) const;
+
  private:
   std::shared_ptr<InternalEvaluator> evaluator;
+  std::shared_ptr<AsyncScorer> scorer;
 };
 }  // namespace cpmml
 
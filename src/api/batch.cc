@@ -0,0 +1,25 @@
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#include "cPMML.h"
+
+namespace cpmml {
+Batch::Batch(const size_t n_rows) : n_rows(n_rows) {}
+
+void Batch::add_numeric(const std::string &name, const double *values, const uint8_t *missing) {
+  numerics.push_back(NumericColumn{name, values, missing});
+}
+
+void Batch::add_categorical(const std::string &name, const int32_t *codes,
+                            const std::vector<std::string> &dictionary) {
+  categoricals.push_back(CategoricalColumn{name, codes, dictionary});
+}
+
+size_t Batch::size() const { return n_rows; }
+
+const std::vector<Batch::NumericColumn> &Batch::numeric_columns() const { return numerics; }
+
+const std::vector<Batch::CategoricalColumn> &Batch::categorical_columns() const { return categoricals; }
+}  // namespace cpmml
@@ -0,0 +1,34 @@
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#include "cPMML.h"
+
+namespace cpmml {
+void Input::set(const size_t handle, const double value) {
+  Field &field = at(handle);
+  field.kind = Kind::NUMERIC;
+  field.number = value;
+}
+
+void Input::set(const size_t handle, const std::string &value) {
+  Field &field = at(handle);
+  field.kind = Kind::STRING;
+  field.string.assign(value);
+}
+
+void Input::set_missing(const size_t handle) { at(handle).kind = Kind::MISSING; }
+
+void Input::clear() {
+  for (auto &field : values) field.kind = Kind::MISSING;
+}
+
+const std::vector<Input::Field> &Input::fields() const { return values; }
+
+Input::Field &Input::at(const size_t handle) {
+  if (handle >= values.size()) values.resize(handle + 1);
+
+  return values[handle];
+}
+}  // namespace cpmml
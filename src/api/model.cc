@@ -5,6 +5,7 @@
  *******************************************************************************/
 
 #include "cPMML.h"
+#include "core/asyncscorer.h"
 #include "core/internal_evaluator.h"
 #include "core/internal_score.h"
 #include "core/modelbuilder.h"
@@ -12,10 +13,46 @@
 #include "utils/utils.h"
 
 namespace cpmml {
-Model::Model(const std::string &model_filepath) : evaluator(ModelBuilder::build(model_filepath, false)) {}
+// Errors not detected by input validation are still raised as exceptions: they are turned into a Status here
+template <class Scoring>
+static Status guarded(const Scoring &scoring) {
+  try {
+    return scoring();
+  } catch (const InvalidValueException &exception) {
+    return Status(Status::Code::INVALID_VALUE, exception.what());
+  } catch (const MissingValueException &exception) {
+    return Status(Status::Code::MISSING_VALUE, exception.what());
+  } catch (const MathException &exception) {
+    return Status(Status::Code::MATH_ERROR, exception.what());
+  } catch (const Exception &exception) {
+    return Status(Status::Code::ERROR, exception.what());
+  }
+}
+
+// Outcome of a scoring run in the background, given its Status and the exception it threw if any
+static Status async_status(const Status &status, const std::exception_ptr &error) {
+  if (!error) return status;
+
+  try {
+    return guarded([&]() -> Status { std::rethrow_exception(error); });
+  } catch (const std::exception &exception) {
+    return Status(Status::Code::ERROR, exception.what());
+  }
+}
+
+// Exception thrown by the synchronous scoring for the same outcome
+static std::exception_ptr async_exception(const Status &status, const std::exception_ptr &error) {
+  return error ? error : std::make_exception_ptr(InvalidValueException(status.message()));
+}
+
+Model::Model(const std::string &model_filepath)
+    : evaluator(ModelBuilder::build(model_filepath, false)), scorer(std::make_shared<AsyncScorer>(evaluator)) {}
 
 Model::Model(const std::string &model_filepath, const bool zipped = false)
-    : evaluator(ModelBuilder::build(model_filepath, zipped)) {}
+    : evaluator(ModelBuilder::build(model_filepath, zipped)), scorer(std::make_shared<AsyncScorer>(evaluator)) {}
+
+Model::Model(const char *data, const size_t size, const bool zipped)
+    : evaluator(ModelBuilder::build(data, size, zipped)), scorer(std::make_shared<AsyncScorer>(evaluator)) {}
 
 bool Model::validate(const std::unordered_map<std::string, std::string> &sample) const {
   return evaluator->validate(sample);
@@ -28,4 +65,148 @@ Prediction Model::score(const std::unordered_map<std::string, std::string> &samp
 std::string Model::predict(const std::unordered_map<std::string, std::string> &sample) const {
   return evaluator->predict(sample);
 }
+
+void Model::score_batch(const Batch &batch, std::string *predictions) const {
+  evaluator->get_model().predict(batch, predictions);
+}
+
+void Model::score_batch(const Batch &batch, double *predictions) const {
+  evaluator->get_model().predict(batch, predictions);
+}
+
+void Model::score_batch_parallel(const Batch &batch, std::string *predictions, const size_t n_threads) const {
+  evaluator->get_model().predict(batch, predictions, n_threads);
+}
+
+void Model::score_batch_parallel(const Batch &batch, double *predictions, const size_t n_threads) const {
+  evaluator->get_model().predict(batch, predictions, n_threads);
+}
+
+size_t Model::get_handle(const std::string &name) const {
+  if (!evaluator->indexer->contains(name))
+    throw InvalidValueException("Field " + name + " is not defined in the model");
+
+  return evaluator->indexer->get_index(name);
+}
+
+bool Model::validate(const Input &input) const { return evaluator->get_model().validate(input); }
+
+Prediction Model::score(const Input &input) const { return Prediction(evaluator->get_model().score(input)); }
+
+std::string Model::predict(const Input &input) const { return evaluator->get_model().predict(input); }
+
+Prediction Model::score(const Input &input, ScoringContext &context) const {
+  evaluator->get_model().score(input, *context.context);
+
+  // the prediction shares the ownership of the context, while pointing to its score
+  return Prediction(std::shared_ptr<InternalScore>(context.context, &context.context->score));
+}
+
+const std::string &Model::predict(const Input &input, ScoringContext &context) const {
+  return evaluator->get_model().predict(input, *context.context);
+}
+
+double Model::predict_double(const std::unordered_map<std::string, std::string> &sample) const {
+  return evaluator->get_model().predict_double(sample);
+}
+
+double Model::predict_double(const Input &input) const { return evaluator->get_model().predict_double(input); }
+
+double Model::predict_double(const Input &input, ScoringContext &context) const {
+  return evaluator->get_model().predict_double(input, *context.context);
+}
+
+int Model::predict_class_index(const std::unordered_map<std::string, std::string> &sample) const {
+  return evaluator->get_model().predict_class_index(sample);
+}
+
+int Model::predict_class_index(const Input &input) const { return evaluator->get_model().predict_class_index(input); }
+
+int Model::predict_class_index(const Input &input, ScoringContext &context) const {
+  return evaluator->get_model().predict_class_index(input, *context.context);
+}
+
+const std::vector<std::string> &Model::classes() const { return evaluator->get_model().predicted_classes; }
+
+Status Model::try_score(const std::unordered_map<std::string, std::string> &sample, Prediction &prediction) const {
+  return guarded([&]() {
+    std::unique_ptr<InternalScore> score;
+    const Status status = evaluator->get_model().try_score(sample, score);
+    if (status.ok()) prediction = Prediction(std::move(score));
+
+    return status;
+  });
+}
+
+Status Model::try_score(const Input &input, Prediction &prediction) const {
+  return guarded([&]() {
+    std::unique_ptr<InternalScore> score;
+    const Status status = evaluator->get_model().try_score(input, score);
+    if (status.ok()) prediction = Prediction(std::move(score));
+
+    return status;
+  });
+}
+
+Status Model::try_predict(const std::unordered_map<std::string, std::string> &sample, std::string &prediction) const {
+  return guarded([&]() { return evaluator->get_model().try_predict(sample, prediction); });
+}
+
+Status Model::try_predict(const Input &input, std::string &prediction) const {
+  return guarded([&]() { return evaluator->get_model().try_predict(input, prediction); });
+}
+
+Status Model::try_predict(const Input &input, ScoringContext &context, std::string &prediction) const {
+  return guarded([&]() { return evaluator->get_model().try_predict(input, *context.context, prediction); });
+}
+
+std::future<Prediction> Model::score_async(const Input &input) const {
+  std::shared_ptr<std::promise<Prediction>> promise = std::make_shared<std::promise<Prediction>>();
+  std::future<Prediction> future = promise->get_future();
+
+  std::unique_ptr<AsyncRequest> request = make_unique<AsyncRequest>(input);
+  request->on_score = [promise](const Status &status, std::exception_ptr error, std::unique_ptr<InternalScore> score) {
+    if (error || !status.ok())
+      promise->set_exception(async_exception(status, error));
+    else
+      promise->set_value(Prediction(std::move(score)));
+  };
+  scorer->submit(std::move(request));
+
+  return future;
+}
+
+void Model::score_async(const Input &input,
+                        const std::function<void(const Status &, const Prediction &)> &callback) const {
+  std::unique_ptr<AsyncRequest> request = make_unique<AsyncRequest>(input);
+  request->on_score = [callback](const Status &status, std::exception_ptr error, std::unique_ptr<InternalScore> score) {
+    callback(async_status(status, error), score ? Prediction(std::move(score)) : Prediction());
+  };
+  scorer->submit(std::move(request));
+}
+
+std::future<std::string> Model::predict_async(const Input &input) const {
+  std::shared_ptr<std::promise<std::string>> promise = std::make_shared<std::promise<std::string>>();
+  std::future<std::string> future = promise->get_future();
+
+  std::unique_ptr<AsyncRequest> request = make_unique<AsyncRequest>(input);
+  request->on_predict = [promise](const Status &status, std::exception_ptr error, std::string prediction) {
+    if (error || !status.ok())
+      promise->set_exception(async_exception(status, error));
+    else
+      promise->set_value(std::move(prediction));
+  };
+  scorer->submit(std::move(request));
+
+  return future;
+}
+
+void Model::predict_async(const Input &input,
+                          const std::function<void(const Status &, const std::string &)> &callback) const {
+  std::unique_ptr<AsyncRequest> request = make_unique<AsyncRequest>(input);
+  request->on_predict = [callback](const Status &status, std::exception_ptr error, std::string prediction) {
+    callback(async_status(status, error), prediction);
+  };
+  scorer->submit(std::move(request));
+}
 }  // namespace cpmml
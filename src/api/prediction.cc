@@ -4,17 +4,74 @@
  * Author: Paolo Iannino
  *******************************************************************************/
 
+#include <algorithm>
+
 #include "cPMML.h"
 #include "core/internal_score.h"
 
 namespace cpmml {
+namespace {
+const std::vector<std::string> &names(const std::shared_ptr<const LabelTable> &table) {
+  static const std::vector<std::string> no_names;
+
+  return table ? table->labels : no_names;
+}
+
+template <class T>
+std::unordered_map<std::string, T> to_map(const std::shared_ptr<const LabelTable> &table, const std::vector<T> &values) {
+  std::unordered_map<std::string, T> result;
+  for (auto i = 0u; i < values.size() && i < names(table).size(); i++) result[(*table)[i]] = values[i];
+
+  return result;
+}
+}  // namespace
+
 Prediction::Prediction(const std::shared_ptr<InternalScore>& score) : score(score) {}
 
 std::string Prediction::as_string() const { return score->score; }
 
 double Prediction::as_double() const { return score->double_score; }
 
-std::unordered_map<std::string, double> Prediction::distribution() const { return score->probabilities; }
-std::unordered_map<std::string, double> Prediction::num_outputs() const { return score->num_outputs; }
-std::unordered_map<std::string, std::string> Prediction::str_outputs() const { return score->str_outputs; }
+std::unordered_map<std::string, double> Prediction::distribution() const {
+  std::unordered_map<std::string, double> result;
+  for (auto i = 0u; i < score->probabilities.size(); i++)
+    if (score->has_probability(i)) result[(*score->labels)[i]] = score->probabilities[i];
+
+  return result;
+}
+
+std::unordered_map<std::string, double> Prediction::num_outputs() const {
+  return to_map(score->num_output_names, score->num_outputs);
+}
+
+std::unordered_map<std::string, std::string> Prediction::str_outputs() const {
+  return to_map(score->str_output_names, score->str_outputs);
+}
+
+const std::vector<std::string>& Prediction::labels() const { return names(score->labels); }
+
+const std::vector<double>& Prediction::probabilities() const { return score->probabilities; }
+
+std::vector<std::pair<size_t, double>> Prediction::top_k(const size_t k) const {
+  std::vector<std::pair<size_t, double>> result;
+  for (auto i = 0u; i < score->probabilities.size(); i++)
+    if (score->has_probability(i)) result.push_back(std::make_pair(i, score->probabilities[i]));
+
+  const size_t n = std::min(k, result.size());
+  std::partial_sort(result.begin(), result.begin() + n, result.end(),
+                    [](const std::pair<size_t, double>& a, const std::pair<size_t, double>& b) {
+                      return a.second > b.second || (a.second == b.second && a.first < b.first);
+                    });
+  result.resize(n);
+
+  return result;
+}
+
+const std::vector<std::string>& Prediction::num_output_names() const { return names(score->num_output_names); }
+
+const std::vector<double>& Prediction::num_output_values() const { return score->num_outputs; }
+
+const std::vector<std::string>& Prediction::str_output_names() const { return names(score->str_output_names); }
+
+const std::vector<std::string>& Prediction::str_output_values() const { return score->str_outputs; }
 }  // namespace cpmml
@@ -0,0 +1,11 @@
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#include "cPMML.h"
+#include "core/internal_context.h"
+
+namespace cpmml {
+ScoringContext::ScoringContext() : context(new InternalContext()) {}
+}  // namespace cpmml
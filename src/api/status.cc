@@ -0,0 +1,31 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#include "cPMML.h"
+
+namespace cpmml {
+Status::Status(const Code code, const size_t field, const std::string &field_name)
+    : status_code(code), field_handle(field), field_name(field_name) {}
+
+Status::Status(const Code code, const std::string &message) : status_code(code), details(message) {}
+
+bool Status::ok() const { return status_code == Code::OK; }
+
+Status::Code Status::code() const { return status_code; }
+
+size_t Status::field() const { return field_handle; }
+
+std::string Status::message() const {
+  if (field_name.empty()) return details;
+
+  switch (status_code) {
+    case Code::MISSING_VALUE:
+      return "Field " + field_name + " is missing";
+    default:
+      return "Field " + field_name + " didn't pass input validation";
+  }
+}
+}  // namespace cpmml
@@ -0,0 +1,14 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#include "cPMML.h"
+#include "utils/threadpool.h"
+
+namespace cpmml {
+size_t num_threads() { return ThreadPool::instance().size(); }
+
+void set_num_threads(const size_t n_threads) { ThreadPool::instance().resize(n_threads); }
+}  // namespace cpmml
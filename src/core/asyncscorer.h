@@ -0,0 +1,258 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_ASYNCSCORER_H
+#define CPMML_ASYNCSCORER_H
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef MULTITHREADING
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#include "cPMML.h"
+#include "internal_evaluator.h"
+#include "internal_model.h"
+#include "internal_score.h"
+#include "sample.h"
+#include "utils/mpmcqueue.h"
+#include "utils/threadpool.h"
+#include "utils/utils.h"
+
+/**
+ * @class AsyncRequest
+ *
+ * Request submitted through cpmml::Model::score_async or
+ * cpmml::Model::predict_async: the input to be scored and the function
+ * receiving the result. Exactly one of on_score and on_predict is set.
+ *
+ * The result is handed over along with the Status of the input validation and
+ * the exception thrown while scoring, if any.
+ */
+class AsyncRequest {
+ public:
+  cpmml::Input input;
+  std::function<void(const cpmml::Status &, std::exception_ptr, std::unique_ptr<InternalScore>)> on_score;
+  std::function<void(const cpmml::Status &, std::exception_ptr, std::string)> on_predict;
+
+  explicit AsyncRequest(const cpmml::Input &input) : input(input) {}
+};
+
+/**
+ * @class AsyncScorer
+ *
+ * Workers scoring the AsyncRequests of a model in the background.
+ *
+ * Requests are handed to the workers through a bounded MPMCQueue, so that
+ * submitting one never blocks on a lock. The workers are started with the
+ * first request, one for each of the NUM_THREADS threads given when building
+ * cPMML, and sleep when there is nothing to do.
+ *
+ * A worker takes at once up to BATCH_BLOCK queued requests. The prediction
+ * requests among them are prepared into a block of samples and predicted
+ * together through InternalModel::predict_block_raw, as the rows of a batch
+ * are, while the score requests are scored one by one.
+ *
+ * When the queue is full, or without MULTITHREADING, requests are run by the
+ * submitting thread. Pending requests are completed before the workers stop,
+ * when the last cpmml::Model sharing the scorer is destroyed.
+ */
+class AsyncScorer {
+ public:
+  enum : size_t { QUEUE_CAPACITY = 1 << 10, BATCH_BLOCK = InternalModel::BATCH_BLOCK, SPIN = 1 << 12 };
+
+  explicit AsyncScorer(const std::shared_ptr<InternalEvaluator> &evaluator)
+      : state(std::make_shared<State>(evaluator)) {}
+
+  AsyncScorer(const AsyncScorer &) = delete;
+
+  AsyncScorer &operator=(const AsyncScorer &) = delete;
+
+#ifndef MULTITHREADING
+  inline void submit(std::unique_ptr<AsyncRequest> request) {
+    AsyncRequest *requests[] = {request.get()};
+    Scratch scratch;
+    run(state->evaluator->get_model(), requests, 1, scratch);
+  }
+#else
+  ~AsyncScorer() {
+    if (!state->queue) return;
+
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->stopping = true;
+    }
+    state->wake.notify_all();
+    for (auto &worker : workers)
+      if (worker.get_id() == std::this_thread::get_id())
+        worker.detach();  // destroyed by a callback of the worker itself, which still holds the state
+      else
+        worker.join();
+  }
+
+  inline void submit(std::unique_ptr<AsyncRequest> request) {
+    std::call_once(started, [this] { start(); });
+
+    if (!state->queue->try_push(request.get())) {
+      AsyncRequest *requests[] = {request.get()};
+      Scratch scratch;
+      run(state->evaluator->get_model(), requests, 1, scratch);
+      return;
+    }
+
+    request.release();
+    state->queued.fetch_add(1);
+    if (state->sleeping.load() != 0) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->wake.notify_one();
+    }
+  }
+#endif
+
+ private:
+  // Memory reused by a worker from one group of requests to the next
+  struct Scratch {
+    std::vector<Sample> block;
+    std::vector<AsyncRequest *> predicted;  // prediction requests prepared into block
+    std::vector<std::string> predictions;
+  };
+
+  struct State {
+    std::shared_ptr<InternalEvaluator> evaluator;
+#ifdef MULTITHREADING
+    std::unique_ptr<MPMCQueue<AsyncRequest *>> queue;
+    std::atomic<size_t> queued{0};    // requests pushed and not yet taken
+    std::atomic<size_t> sleeping{0};  // workers waiting for requests
+    std::mutex mutex;                 // guards the wake up of the workers
+    std::condition_variable wake;
+    bool stopping = false;
+#endif
+
+    explicit State(const std::shared_ptr<InternalEvaluator> &evaluator) : evaluator(evaluator) {}
+  };
+
+  std::shared_ptr<State> state;
+#ifdef MULTITHREADING
+  std::once_flag started;
+  std::vector<std::thread> workers;
+
+  inline void start() {
+    state->queue = make_unique<MPMCQueue<AsyncRequest *>>(QUEUE_CAPACITY);
+    const size_t n_workers = NUM_THREADS > 1 ? NUM_THREADS : 1;
+    for (auto i = 0u; i < n_workers; i++) workers.emplace_back(&AsyncScorer::loop, state);
+  }
+
+  // Each worker holds the state, so that the model outlives it even if the scorer is destroyed by a callback
+  static void loop(const std::shared_ptr<State> state) {
+    ThreadPool::Serial serial(NUM_THREADS > 1);  // the threads are already busy with the other requests
+    const InternalModel &model = state->evaluator->get_model();
+    Scratch scratch;
+    AsyncRequest *requests[BATCH_BLOCK];
+    while (true) {
+      size_t n = 0;
+      for (auto spin = 0u; n == 0 && spin < SPIN; spin++)
+        while (n < BATCH_BLOCK && state->queue->try_pop(requests[n])) n++;
+
+      if (n == 0) {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->sleeping.fetch_add(1);
+        state->wake.wait(lock, [&] { return state->stopping || state->queued.load() != 0; });
+        state->sleeping.fetch_sub(1);
+        if (state->stopping && state->queued.load() == 0) return;
+        continue;
+      }
+
+      state->queued.fetch_sub(n);
+      run(model, requests, n, scratch);
+      for (auto i = 0u; i < n; i++) delete requests[i];
+    }
+  }
+#endif
+
+  // Runs the n requests, predicting the prediction requests as a block
+  static void run(const InternalModel &model, AsyncRequest *const *requests, const size_t n, Scratch &scratch) {
+    if (scratch.block.size() < n) {
+      scratch.block.resize(n, model.base_sample);
+      scratch.predicted.resize(n);
+      scratch.predictions.resize(n);
+    }
+
+    size_t m = 0;
+    for (auto i = 0u; i < n; i++) {
+      AsyncRequest &request = *requests[i];
+      if (request.on_score) {
+        score(model, request);
+        continue;
+      }
+
+      cpmml::Status status;
+      try {
+        scratch.block[m].reset(model.base_sample);
+        if (model.try_prepare(request.input, scratch.block[m], status)) {
+          scratch.predicted[m++] = &request;
+          continue;
+        }
+        complete(request.on_predict, status, nullptr, std::string());
+      } catch (...) {
+        complete(request.on_predict, status, std::current_exception(), std::string());
+      }
+    }
+    if (m == 0) return;
+
+    try {
+      model.predict_block_raw(scratch.block.data(), m, scratch.predictions.data());
+    } catch (...) {  // the error of a sample must not spoil the others: they are predicted one by one
+      for (auto i = 0u; i < m; i++) {
+        try {
+          scratch.predictions[i] = model.predict_raw(scratch.block[i]);
+        } catch (...) {
+          complete(scratch.predicted[i]->on_predict, cpmml::Status(), std::current_exception(), std::string());
+          scratch.predicted[i] = nullptr;
+        }
+      }
+    }
+
+    for (auto i = 0u; i < m; i++) {
+      if (!scratch.predicted[i]) continue;
+      try {
+        complete(scratch.predicted[i]->on_predict, cpmml::Status(), nullptr, model.target(scratch.predictions[i]));
+      } catch (...) {
+        complete(scratch.predicted[i]->on_predict, cpmml::Status(), std::current_exception(), std::string());
+      }
+    }
+  }
+
+  static void score(const InternalModel &model, AsyncRequest &request) {
+    std::unique_ptr<InternalScore> score;
+    cpmml::Status status;
+    try {
+      status = model.try_score(request.input, score);
+    } catch (...) {
+      complete(request.on_score, status, std::current_exception(), std::unique_ptr<InternalScore>());
+      return;
+    }
+    complete(request.on_score, status, nullptr, std::move(score));
+  }
+
+  // Exceptions thrown by the function receiving the result can't reach anybody, so they are dropped
+  template <class Callback, class Result>
+  static void complete(const Callback &callback, const cpmml::Status &status, std::exception_ptr error,
+                       Result result) {
+    try {
+      callback(status, error, std::move(result));
+    } catch (...) {
+    }
+  }
+};
+
+#endif
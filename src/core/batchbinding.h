@@ -0,0 +1,106 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_BATCHBINDING_H
+#define CPMML_BATCHBINDING_H
+
+#include <vector>
+
+#include "cPMML.h"
+#include "miningfield.h"
+#include "value.h"
+
+/**
+ * @class ColumnBinding
+ *
+ * Class associating a column of a cpmml::Batch to the MiningField it provides
+ * values for.
+ *
+ * Categorical columns are converted once per dictionary entry, so that reading
+ * a value from the column is just an array access. Dictionary entries which
+ * cannot be converted to the type of the field are treated as missing values.
+ */
+class ColumnBinding {
+ public:
+  const MiningField *miningfield = nullptr;
+  const double *values = nullptr;
+  const uint8_t *missing = nullptr;
+  const int32_t *codes = nullptr;
+  std::vector<Value> dictionary;
+
+  ColumnBinding() = default;
+
+  ColumnBinding(const MiningField &miningfield, const cpmml::Batch::NumericColumn &column)
+      : miningfield(&miningfield), values(column.values), missing(column.missing) {
+    if (miningfield.datatype == DataType::DataTypeValue::STRING)
+      throw cpmml::InvalidValueException("Field " + miningfield.name + " is categorical but was provided as numeric");
+  }
+
+  ColumnBinding(const MiningField &miningfield, const cpmml::Batch::CategoricalColumn &column)
+      : miningfield(&miningfield), codes(column.codes), dictionary(to_values(miningfield, column.dictionary)) {}
+
+  inline Value value(const size_t &row) const {
+    if (codes) return codes[row] < 0 || size_t(codes[row]) >= dictionary.size() ? Value() : dictionary[codes[row]];
+
+    if (missing && (missing[row / 8] >> (row % 8) & 1)) return Value();
+
+    return Value(values[row]);
+  }
+
+  static std::vector<Value> to_values(const MiningField &miningfield, const std::vector<std::string> &dictionary) {
+    std::vector<Value> result;
+    result.reserve(dictionary.size());
+    Value value;
+    for (const auto &category : dictionary)  // a category which cannot be converted is missing
+      result.push_back(miningfield.try_createValue(category, value) ? value : Value());
+
+    return result;
+  }
+};
+
+/**
+ * @class BatchBinding
+ *
+ * Class associating the columns of a cpmml::Batch to the MiningFields of a
+ * MiningSchema.
+ *
+ * It is built once per batch, so that the name of each field is resolved once
+ * rather than once per sample. The MiningFields without a corresponding column
+ * are kept apart, since they are missing for every sample of the batch.
+ */
+class BatchBinding {
+ public:
+  std::vector<ColumnBinding> columns;
+  std::vector<const MiningField *> unbound;
+
+  BatchBinding() = default;
+
+  BatchBinding(const cpmml::Batch &batch, const std::vector<MiningField> &miningfields, const size_t &target_index) {
+    std::unordered_map<std::string, const MiningField *> pending;
+    for (const auto &miningfield : miningfields)
+      if (miningfield.index != target_index) pending[miningfield.name] = &miningfield;
+
+    for (const auto &column : batch.numeric_columns()) {
+      auto miningfield = pending.find(column.name);
+      if (miningfield == pending.end()) continue;  // column not used by the model
+
+      columns.push_back(ColumnBinding(*miningfield->second, column));
+      pending.erase(miningfield);
+    }
+
+    for (const auto &column : batch.categorical_columns()) {
+      auto miningfield = pending.find(column.name);
+      if (miningfield == pending.end()) continue;  // column not used by the model
+
+      columns.push_back(ColumnBinding(*miningfield->second, column));
+      pending.erase(miningfield);
+    }
+
+    for (const auto &miningfield : pending) unbound.push_back(miningfield.second);
+  }
+};
+
+#endif
@@ -55,7 +55,7 @@ class BuiltInFunction {  // inputs are mapped by position
   std::string function_string;
   BuiltInFunctionType function_type = BuiltInFunctionType::IDENTITY;
   int n_args = -1;
-  std::function<Value(const std::vector<Value> &)> function;
+  std::function<Value(const Value *, const size_t)> function;
 
   BuiltInFunction() = default;
 
@@ -125,7 +125,7 @@ class BuiltInFunction {  // inputs are mapped by position
     }
   }
 
-  static std::function<Value(const std::vector<Value> &)> get_function(const BuiltInFunctionType &function_type) {
+  static std::function<Value(const Value *, const size_t)> get_function(const BuiltInFunctionType &function_type) {
     switch (function_type) {
       case BuiltInFunctionType::PLUS:
         return plus;
@@ -174,56 +174,75 @@ class BuiltInFunction {  // inputs are mapped by position
     }
   }
 
-  inline Value operator()(const std::vector<Value> &input) const {
-    if (n_args != -1 && n_args != (int)input.size()) throw cpmml::InvalidValueException("Wrong number of inputs");
-    return function(input);
+  // Result of the function applied to the n arguments starting at input
+  inline Value operator()(const Value *input, const size_t n) const {
+    if (n_args != -1 && n_args != (int)n) throw cpmml::InvalidValueException("Wrong number of inputs");
+    return function(input, n);
   }
 
-  inline static Value plus(const std::vector<Value> &input) { return input[0] + input[1]; }
-  inline static Value minus(const std::vector<Value> &input) { return input[0] - input[1]; }
-  inline static Value mul(const std::vector<Value> &input) { return input[0] * input[1]; }
-  inline static Value div(const std::vector<Value> &input) { return input[0] / input[1]; }
-  inline static Value max(const std::vector<Value> &input) { return Value::max(input); }
-  inline static Value min(const std::vector<Value> &input) { return Value::min(input); }
-  inline static Value sum(const std::vector<Value> &input) { return Value::sum(input); }
-  inline static Value avg(const std::vector<Value> &input) { return Value::sum(input) / Value(input.size()); }
-  inline static Value is_missing(const std::vector<Value> &input) {
+  inline static Value plus(const Value *input, const size_t) { return input[0] + input[1]; }
+  inline static Value minus(const Value *input, const size_t) { return input[0] - input[1]; }
+  inline static Value mul(const Value *input, const size_t) { return input[0] * input[1]; }
+  inline static Value div(const Value *input, const size_t) { return input[0] / input[1]; }
+  inline static Value max(const Value *input, const size_t n) { return Value::max(input, input + n); }
+  inline static Value min(const Value *input, const size_t n) { return Value::min(input, input + n); }
+  inline static Value sum(const Value *input, const size_t n) { return Value::sum(input, input + n); }
+  inline static Value avg(const Value *input, const size_t n) { return Value::sum(input, input + n) / Value(n); }
+  inline static Value is_missing(const Value *input, const size_t) {
     return Value(input[0].missing, DataType::DataTypeValue::BOOLEAN);
   }
-  inline static Value is_notmissing(const std::vector<Value> &input) {
+  inline static Value is_notmissing(const Value *input, const size_t) {
     return Value(!input[0].missing, DataType::DataTypeValue::BOOLEAN);
   }
-  inline static Value equal(const std::vector<Value> &input) {
-    return Value(input[0] == input[1], DataType::DataTypeValue::BOOLEAN);
-  }
-  inline static Value not_equal(const std::vector<Value> &input) {
-    return Value(input[0] != input[1], DataType::DataTypeValue::BOOLEAN);
-  }
-  inline static Value less_than(const std::vector<Value> &input) {
+  inline static Value equal(const Value *input, const size_t) { return same(input[0], input[1]); }
+  inline static Value not_equal(const Value *input, const size_t) { return negate(same(input[0], input[1])); }
+  inline static Value less_than(const Value *input, const size_t) {
     return Value(input[0] < input[1], DataType::DataTypeValue::BOOLEAN);
   }
-  inline static Value less_thanorequal(const std::vector<Value> &input) {
+  inline static Value less_thanorequal(const Value *input, const size_t) {
     return Value(input[0] <= input[1], DataType::DataTypeValue::BOOLEAN);
   }
-  inline static Value greater_than(const std::vector<Value> &input) {
+  inline static Value greater_than(const Value *input, const size_t) {
     return Value(input[0] > input[1], DataType::DataTypeValue::BOOLEAN);
   }
-  inline static Value greater_thanorequal(const std::vector<Value> &input) {
+  inline static Value greater_thanorequal(const Value *input, const size_t) {
     return Value(input[0] >= input[1], DataType::DataTypeValue::BOOLEAN);
   }
-  inline static Value exp(const std::vector<Value> &input) {
+  inline static Value exp(const Value *input, const size_t) {
     return Value(std::exp(input[0].value), DataType::DataTypeValue::DOUBLE);
   }
-  inline static Value is_in(const std::vector<Value> &input) {
-    auto found = std::find(input.begin() + 1, input.end(), input[0]);
-    return Value(found != input.begin() && found != input.end(), DataType::DataTypeValue::BOOLEAN);
+  inline static Value is_in(const Value *input, const size_t n) {
+    Value result(false, DataType::DataTypeValue::BOOLEAN);
+    for (auto i = 1u; i < n; i++) {
+      const Value found = same(input[0], input[i]);
+      if (found.missing)
+        result = found;
+      else if (found.value)
+        return found;
+    }
+
+    return result;
+  }
+  inline static Value is_notin(const Value *input, const size_t n) { return negate(is_in(input, n)); }
+
+  // Whether a and b are the same value. Strings missing from the dictionary of the model share the same code, so two
+  // of them are compared through their string when it is kept, and are unknown (missing) otherwise.
+  inline static Value same(const Value &a, const Value &b) {
+    if (!a.unseen || !b.unseen) return Value(a == b, DataType::DataTypeValue::BOOLEAN);
+
+#ifdef REGEX_SUPPORT
+    return Value(a.svalue == b.svalue, DataType::DataTypeValue::BOOLEAN);
+#else
+    return Value();
+#endif
   }
-  inline static Value is_notin(const std::vector<Value> &input) {
-    return Value(!(is_in(input).value), DataType::DataTypeValue::BOOLEAN);
+
+  inline static Value negate(const Value &value) {
+    return value.missing ? value : Value(!value.value, DataType::DataTypeValue::BOOLEAN);
   }
 
 #ifdef REGEX_SUPPORT
-  inline static Value replace(const std::vector<Value> &input) {
+  inline static Value replace(const Value *input, const size_t) {
     return input[0].replace(input[1].svalue, input[2].svalue);
   }
 #endif
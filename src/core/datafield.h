@@ -16,7 +16,9 @@
 #include "intervalbuilder.h"
 #include "optype.h"
 #include "predicate.h"
+#include "predicateprogram.h"
 #include "property.h"
+#include "stringdictionary.h"
 #include "value.h"
 #include "xmlnode.h"
 
@@ -27,7 +29,7 @@
  *
  * It defines a feature available to the model, along with the values it can
  * assume. The constraints on the admissible values are enforced through the
- * class Predicate.
+ * class Predicate, compiled into a PredicateProgram.
  */
 class DataField {
  public:
@@ -37,18 +39,24 @@ class DataField {
   size_t index = std::numeric_limits<size_t>::max();
   OpType optype;
   Value missing_replacement;
-  Predicate constraints;
+  PredicateProgram constraints;
+  std::shared_ptr<const StringDictionary> dictionary;  // the one of the model, to encode strings during scoring
 
   DataField() = default;
 
   DataField(const std::string &name, const DataType &datatype)
-      : n_values(1), name(name), datatype(datatype), index(std::numeric_limits<size_t>::max()) {}
+      : n_values(1),
+        name(name),
+        datatype(datatype),
+        index(std::numeric_limits<size_t>::max()),
+        dictionary(StringDictionary::Loading::current()) {}
 
   DataField(const XmlNode &node, const std::shared_ptr<Indexer> &indexer)
       : name(node.get_attribute("name")),
         datatype(node.get_attribute("dataType")),
         index(indexer->get_or_set(name, datatype).first),
-        optype(node.get_attribute("optype")) {
+        optype(node.get_attribute("optype")),
+        dictionary(StringDictionary::Loading::current()) {
     auto values = node.get_childs("Value");
     std::vector<Predicate> tmp_contraints;
     std::set<Value> allowed_values;
@@ -73,13 +81,32 @@ class DataField {
     auto intervals = node.get_childs("Interval");
     for (const auto &interval : intervals) tmp_contraints.push_back(IntervalBuilder::build(interval, index, datatype));
 
-    if (tmp_contraints.size() > 0) constraints = Predicate(tmp_contraints, "AND");
+    if (tmp_contraints.size() > 0) constraints = PredicateProgram(Predicate(tmp_contraints, "AND"));
 
     n_values = allowed_values.size() > 0 ? allowed_values.size() : 1;
   };
 
-  inline bool validate(const Sample &sample) const { return constraints.is_empty ? true : constraints(sample); }
-  inline Value createValue(const std::string &value) const { return Value(value, datatype); }
+  inline bool validate(const Sample &sample) const { return constraints(sample); }
+  inline Value createValue(const std::string &value) const {
+    if (datatype == DataType::DataTypeValue::STRING && dictionary) return Value::encoded(value, *dictionary);
+
+    return Value(value, datatype);
+  }
+
+  // As createValue, but a value which cannot be converted is signalled through the return value
+  inline bool try_createValue(const std::string &value, Value &result) const {
+    switch (datatype.value) {
+      case DataType::DataTypeValue::STRING:
+      case DataType::DataTypeValue::BOOLEAN:
+        result = createValue(value);
+        return true;
+      default:
+        double converted;
+        if (!try_to_double(value, converted)) return false;
+        result = Value(converted);
+        return true;
+    }
+  }
 
   static std::unordered_map<std::string, DataField> to_datafields(const std::vector<XmlNode> &nodes,
                                                                   const std::shared_ptr<Indexer> &indexer) {
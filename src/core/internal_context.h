@@ -0,0 +1,50 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_INTERNALCONTEXT_H
+#define CPMML_INTERNALCONTEXT_H
+
+#include <string>
+#include <vector>
+
+#include "internal_score.h"
+#include "sample.h"
+
+class InternalModel;
+
+/**
+ * @class InternalContext
+ *
+ * Class holding the scratch memory used while scoring a sample: the Sample
+ * itself, the InternalScore and the buffers for intermediate values.
+ *
+ * It is the internal representation of cpmml::ScoringContext. Since it is
+ * reset rather than rebuilt between two scorings, once it has been used the
+ * first time no further memory is allocated. It is bound to the model it is
+ * used with, and it is rebuilt when used with a different one.
+ */
+class InternalContext {
+ public:
+  const InternalModel *model = nullptr;
+  Sample sample;
+  InternalScore score;
+  std::vector<double> scores;
+  std::string prediction;
+
+  InternalContext() = default;
+
+  inline void bind(const InternalModel *model, const Sample &base_sample) {
+    if (this->model != model) {
+      this->model = model;
+      score = InternalScore();
+      scores.clear();
+    }
+
+    sample.reset(base_sample);
+  }
+};
+
+#endif
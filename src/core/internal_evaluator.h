@@ -12,6 +12,7 @@
 
 #include "datadictionary.h"
 #include "header.h"
+#include "internal_model.h"
 #include "internal_score.h"
 #include "options.h"
 #include "transformationdictionary.h"
@@ -53,7 +54,7 @@ class InternalEvaluator {
                                       ? TransformationDictionary(node.get_child("TransformationDictionary"), indexer)
                                       : TransformationDictionary()){};
 
-  virtual inline bool validate(const std::unordered_map<std::string, std::string> &sample) { return false; }
+  virtual bool validate(const std::unordered_map<std::string, std::string> &sample) const = 0;
 
   virtual std::unique_ptr<InternalScore> score(const std::unordered_map<std::string, std::string> &sample) const = 0;
 
@@ -62,6 +63,8 @@ class InternalEvaluator {
 
   virtual inline std::string get_target_name() const { return ""; }
 
+  virtual const InternalModel &get_model() const = 0;
+
   InternalEvaluator(const InternalEvaluator &) = default;
 
   InternalEvaluator(InternalEvaluator &&) = default;
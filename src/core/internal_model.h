@@ -10,11 +10,14 @@
 #include <string>
 
 #include "dagbuilder.h"
+#include "internal_context.h"
 #include "miningfunction.h"
 #include "miningschema.h"
 #include "output/outputdictionary.h"
 #include "target.h"
 #include "transformationdictionary.h"
+#include "utils/threadpool.h"
+#include "utils/workstealing.h"
 
 /**
  * @class InternalModel
@@ -44,10 +47,17 @@ class InternalModel {
   MiningField target_field;
   TransformationDictionary transformation_dictionary;
   bool has_local_transformations = false;
+  std::shared_ptr<LabelTable> labels = std::make_shared<LabelTable>();  // labels of the probabilities of the scores
   Target target;
   OutputDictionary output;
   Sample base_sample;
   std::vector<std::string> derivedfields_dag;
+  std::vector<std::string> class_table;                 // classes as returned by predict_raw, indexed by class id
+  std::vector<std::string> predicted_classes;           // classes as returned by predict, indexed by class id
+  std::unordered_map<std::string, int> class_ids;       // class id of each class in class_table
+  std::vector<uint32_t> class_labels;                   // label id of each class in class_table
+
+  enum : size_t { BATCH_BLOCK = 64 };  // samples predicted together by the batch predictions
 
   InternalModel() = default;
 
@@ -57,8 +67,8 @@ class InternalModel {
         mining_schema(MiningSchema(node.get_child("MiningSchema"), data_dictionary)),
         target_field(get_target(mining_function, mining_schema, indexer)),
         has_local_transformations(false),
-        target(get_target(node, mining_schema, transformation_dictionary, mining_function)),
-        output(get_output(node, indexer, target_field.name)) {
+        target(get_target(node, mining_schema, transformation_dictionary, mining_function, labels)),
+        output(get_output(node, indexer, target_field.name, *labels)) {
     check_scorable(node);
   }
 
@@ -70,8 +80,8 @@ class InternalModel {
         target_field(get_target(mining_function, mining_schema, indexer)),
         transformation_dictionary(transformation_dictionary),
         has_local_transformations(add_local_transformations(node, this->transformation_dictionary, indexer)),
-        target(get_target(node, mining_schema, this->transformation_dictionary, mining_function)),
-        output(get_output(node, indexer, target_field.name)),
+        target(get_target(node, mining_schema, this->transformation_dictionary, mining_function, labels)),
+        output(get_output(node, indexer, target_field.name, *labels)),
         base_sample(create_basesample(indexer)),
         derivedfields_dag(DagBuilder::build(mining_schema, this->transformation_dictionary)) {
     check_scorable(node);
@@ -80,27 +90,35 @@ class InternalModel {
   inline bool validate(const std::unordered_map<std::string, std::string> &sample) const {
     Sample internal_sample = base_sample;
     mining_schema.prepare(internal_sample, sample);
-    if (!transformation_dictionary.empty)
-      for (const auto &derivedfield_name : derivedfields_dag)
-        transformation_dictionary[derivedfield_name].prepare(internal_sample);
+    prepare_derivedfields(internal_sample);
 
     return mining_schema.validate(internal_sample);
   }
 
-  inline void augment_first(Sample &sample) const {
+  inline bool validate(const cpmml::Input &input) const {
+    Sample internal_sample = base_sample;
+    mining_schema.prepare(internal_sample, input);
+    prepare_derivedfields(internal_sample);
+
+    return mining_schema.validate(internal_sample);
+  }
+
+  inline void prepare_derivedfields(Sample &sample) const {
     if (!transformation_dictionary.empty)
       for (const auto &derivedfield_name : derivedfields_dag)
         transformation_dictionary[derivedfield_name].prepare(sample);
+  }
+
+  inline void augment_first(Sample &sample) const {
+    prepare_derivedfields(sample);
 
-    sample.change_value(indexer->get_index(target_field.name),
-                        Value(target(predict_raw(sample)), target_field.datatype));
+    sample.change_value(indexer->get_index(target_field.name), target_field.createValue(target(predict_raw(sample))));
 
     output.prepare(sample);
   };
 
   inline void augment(Sample &sample) const {
-    sample.change_value(indexer->get_index(target_field.name),
-                        Value(target(predict_raw(sample)), target_field.datatype));
+    sample.change_value(indexer->get_index(target_field.name), target_field.createValue(target(predict_raw(sample))));
 
     output.prepare(sample);
   };
@@ -115,13 +133,18 @@ class InternalModel {
 
   inline std::unique_ptr<InternalScore> score(const std::unordered_map<std::string, std::string> &sample) const {
     Sample internal_sample = base_sample;
-    mining_schema.prepare(internal_sample, sample);
-    if (!transformation_dictionary.empty)
-      for (const auto &derivedfield_name : derivedfields_dag)
-        transformation_dictionary[derivedfield_name].prepare(internal_sample);
+    prepare(sample, internal_sample);
 
-    if (!mining_schema.validate(internal_sample))
-      throw cpmml::InvalidValueException("Sample: " + to_string(sample) + "didn't pass input validation");
+    std::unique_ptr<InternalScore> score = score_raw(internal_sample);
+    target(*score);
+    output.add_output(internal_sample, *score);
+
+    return score;
+  };
+
+  inline std::unique_ptr<InternalScore> score(const cpmml::Input &input) const {
+    Sample internal_sample = base_sample;
+    prepare(input, internal_sample);
 
     std::unique_ptr<InternalScore> score = score_raw(internal_sample);
     target(*score);
@@ -130,35 +153,247 @@ class InternalModel {
     return score;
   };
 
+  inline const InternalScore &score(const cpmml::Input &input, InternalContext &context) const {
+    context.bind(this, base_sample);
+    prepare(input, context.sample);
+
+    score_into(context.sample, context);
+    target(context.score);
+    output.add_output(context.sample, context.score);
+
+    return context.score;
+  };
+
   virtual std::unique_ptr<InternalScore> score_raw(const Sample &sample) const = 0;
 
+  // As score_raw, but the score is written into the memory owned by context
+  virtual void score_into(const Sample &sample, InternalContext &context) const {
+    context.score = std::move(*score_raw(sample));
+  }
+
   inline std::string predict(const std::unordered_map<std::string, std::string> &sample) const {
     Sample internal_sample = base_sample;
-    mining_schema.prepare(internal_sample, sample);
-    if (!transformation_dictionary.empty)
-      for (const auto &derivedfield_name : derivedfields_dag)
-        transformation_dictionary[derivedfield_name].prepare(internal_sample);
+    prepare(sample, internal_sample);
 
-    if (!mining_schema.validate(internal_sample))
-      throw cpmml::InvalidValueException("Sample: " + to_string(sample) + "didn't pass input validation");
+    return target(predict_raw(internal_sample));
+  };
+
+  inline double predict_double(const std::unordered_map<std::string, std::string> &sample) const {
+    Sample internal_sample = base_sample;
+    prepare(sample, internal_sample);
+
+    return predict_double(internal_sample);
+  };
+
+  inline double predict_double(const cpmml::Input &input) const {
+    Sample internal_sample = base_sample;
+    prepare(input, internal_sample);
+
+    return predict_double(internal_sample);
+  };
+
+  inline double predict_double(const cpmml::Input &input, InternalContext &context) const {
+    context.bind(this, base_sample);
+    prepare(input, context.sample);
+
+    return predict_double(context.sample);
+  };
+
+  // The prediction flows as a double from the model to the target, with no string conversion in between
+  inline double predict_double(const Sample &sample) const {
+    if (mining_function.value == MiningFunction::MiningFunctionType::CLASSIFICATION) {
+      double predicted;
+      return try_to_double(target(predict_raw(sample)), predicted) ? predicted : double_min();
+    }
+
+    double predicted;
+    if (!predict_double_raw(sample, predicted)) return target.default_prediction();
+
+    return target(predicted);
+  }
+
+  inline int predict_class_index(const std::unordered_map<std::string, std::string> &sample) const {
+    Sample internal_sample = base_sample;
+    prepare(sample, internal_sample);
+
+    return predict_class_index(internal_sample);
+  };
+
+  inline int predict_class_index(const cpmml::Input &input) const {
+    Sample internal_sample = base_sample;
+    prepare(input, internal_sample);
+
+    return predict_class_index(internal_sample);
+  };
+
+  inline int predict_class_index(const cpmml::Input &input, InternalContext &context) const {
+    context.bind(this, base_sample);
+    prepare(input, context.sample);
+
+    return predict_class_index(context.sample);
+  };
+
+  inline int predict_class_index(const Sample &sample) const {
+    if (mining_function.value != MiningFunction::MiningFunctionType::CLASSIFICATION)
+      throw cpmml::Exception("Class index is available only for classification models");
+
+    return predict_class_raw(sample);
+  }
+
+  inline void prepare(const std::unordered_map<std::string, std::string> &sample, Sample &internal_sample) const {
+    cpmml::Status status;
+    if (!try_prepare(sample, internal_sample, status)) throw cpmml::InvalidValueException(status.message());
+  }
+
+  // As prepare, but a sample not passing validation is reported through status rather than with an exception
+  template <class InputT>
+  inline bool try_prepare(const InputT &input, Sample &internal_sample, cpmml::Status &status) const {
+    mining_schema.prepare(internal_sample, input);
+    prepare_derivedfields(internal_sample);
+
+    const size_t invalid = mining_schema.find_invalid(internal_sample);
+    if (invalid == mining_schema.miningfields.size()) return true;
+
+    const MiningField &field = mining_schema.miningfields[invalid];
+    status = cpmml::Status(
+        internal_sample[field.index].value.missing ? cpmml::Status::Code::MISSING_VALUE
+                                                   : cpmml::Status::Code::INVALID_VALUE,
+        field.index, field.name);
+
+    return false;
+  }
+
+  template <class InputT>
+  inline cpmml::Status try_score(const InputT &input, std::unique_ptr<InternalScore> &score) const {
+    cpmml::Status status;
+    Sample internal_sample = base_sample;
+    if (!try_prepare(input, internal_sample, status)) return status;
+
+    score = score_raw(internal_sample);
+    target(*score);
+    output.add_output(internal_sample, *score);
+
+    return status;
+  }
+
+  template <class InputT>
+  inline cpmml::Status try_predict(const InputT &input, std::string &prediction) const {
+    cpmml::Status status;
+    Sample internal_sample = base_sample;
+    if (!try_prepare(input, internal_sample, status)) return status;
+
+    prediction = target(predict_raw(internal_sample));
+
+    return status;
+  }
+
+  inline cpmml::Status try_predict(const cpmml::Input &input, InternalContext &context,
+                                   std::string &prediction) const {
+    cpmml::Status status;
+    context.bind(this, base_sample);
+    if (!try_prepare(input, context.sample, status)) return status;
+
+    prediction = target(predict_raw(context.sample));
+
+    return status;
+  }
+
+  inline std::string predict(const cpmml::Input &input) const {
+    Sample internal_sample = base_sample;
+    prepare(input, internal_sample);
 
     return target(predict_raw(internal_sample));
   };
 
+  inline const std::string &predict(const cpmml::Input &input, InternalContext &context) const {
+    context.bind(this, base_sample);
+    prepare(input, context.sample);
+
+    context.prediction = target(predict_raw(context.sample));
+
+    return context.prediction;
+  };
+
+  inline void prepare(const cpmml::Input &input, Sample &internal_sample) const {
+    cpmml::Status status;
+    if (!try_prepare(input, internal_sample, status)) throw cpmml::InvalidValueException(status.message());
+  }
+
+  // Rows of a batch are prepared and predicted in blocks of BATCH_BLOCK samples, see predict_block_raw. The blocks are
+  // split among n_threads workers (see WorkStealing), each with its own samples and buffers: since every block writes
+  // to its own slice of predictions, the workers don't need to synchronize.
+  template <class PredictionT>
+  inline void predict(const cpmml::Batch &batch, PredictionT *predictions, const size_t n_threads = 1) const {
+    BatchBinding binding(batch, mining_schema.miningfields, mining_schema.target_index);
+    WorkStealing blocks((batch.size() + BATCH_BLOCK - 1) / BATCH_BLOCK, n_threads);
+
+    blocks.run([&](const size_t worker) {
+      ThreadPool::Serial serial(blocks.workers() > 1);  // the threads are already busy with the other blocks
+      std::vector<Sample> block(std::min<size_t>(BATCH_BLOCK, batch.size()), base_sample);
+      std::vector<std::string> raw_predictions;
+      std::vector<uint8_t> found;
+      size_t index;
+      while (blocks.next(worker, index)) {
+        const size_t start = index * BATCH_BLOCK;
+        const size_t n = std::min(block.size(), batch.size() - start);
+        for (auto i = 0u; i < n; i++) prepare(binding, start + i, block[i]);
+
+        predict_block(block, n, raw_predictions, found, predictions + start);
+      }
+    });
+  }
+
+  inline void predict_block(const std::vector<Sample> &block, const size_t n, std::vector<std::string> &,
+                            std::vector<uint8_t> &, std::string *predictions) const {
+    predict_block_raw(block.data(), n, predictions);
+    for (auto i = 0u; i < n; i++) predictions[i] = target(predictions[i]);
+  }
+
+  inline void predict_block(const std::vector<Sample> &block, const size_t n, std::vector<std::string> &raw_predictions,
+                            std::vector<uint8_t> &found, double *predictions) const {
+    if (mining_function.value == MiningFunction::MiningFunctionType::CLASSIFICATION) {
+      raw_predictions.resize(block.size());
+      predict_block_raw(block.data(), n, raw_predictions.data());
+      for (auto i = 0u; i < n; i++) {
+        double predicted;
+        predictions[i] = try_to_double(target(raw_predictions[i]), predicted) ? predicted : double_min();
+      }
+    } else {
+      found.resize(block.size());
+      predict_double_block_raw(block.data(), n, predictions, found.data());
+      for (auto i = 0u; i < n; i++) predictions[i] = found[i] ? target(predictions[i]) : target.default_prediction();
+    }
+  }
+
+  inline std::string predict(const BatchBinding &binding, const size_t &row, Sample &internal_sample) const {
+    prepare(binding, row, internal_sample);
+
+    return target(predict_raw(internal_sample));
+  }
+
+  inline void prepare(const BatchBinding &binding, const size_t &row, Sample &internal_sample) const {
+    internal_sample.reset(base_sample);
+    mining_schema.prepare(internal_sample, binding, row);
+    prepare_derivedfields(internal_sample);
+
+    if (!mining_schema.validate(internal_sample))
+      throw cpmml::InvalidValueException("Sample at row " + std::to_string(row) + " didn't pass input validation");
+  }
+
   static inline Target get_target(const XmlNode &node, const MiningSchema &mining_schema,
                                   const TransformationDictionary &transformation_dictionary,
-                                  const MiningFunction &mining_function) {
+                                  const MiningFunction &mining_function, const std::shared_ptr<LabelTable> &labels) {
     if (node.exists_child("Targets"))
       if (node.get_child("Targets").exists_child("Target"))
         return Target(node.get_child("Targets").get_child("Target"), mining_schema, transformation_dictionary,
-                      mining_function);
+                      mining_function, labels);
 
     return Target();
   }
 
   static inline OutputDictionary get_output(const XmlNode &node, const std::shared_ptr<Indexer> &indexer,
-                                            const std::string &target_field_name) {
-    return node.exists_child("Output") ? OutputDictionary(node.get_child("Output"), indexer, target_field_name)
+                                            const std::string &target_field_name, LabelTable &labels) {
+    return node.exists_child("Output") ? OutputDictionary(node.get_child("Output"), indexer, target_field_name, labels)
                                        : OutputDictionary();
   }
 
@@ -202,6 +437,49 @@ class InternalModel {
 
   virtual std::string predict_raw(const Sample &sample) const = 0;
 
+  // Numeric prediction of the model, before applying the target. It returns false when the model doesn't produce any.
+  virtual bool predict_double_raw(const Sample &sample, double &predicted) const {
+    const std::string raw_prediction = predict_raw(sample);
+    if (raw_prediction == "") return false;
+
+    if (!try_to_double(raw_prediction, predicted)) predicted = double_min();
+
+    return true;
+  }
+
+  // As predict_raw, for the n samples starting at samples. Models which can score several samples at once override it.
+  virtual void predict_block_raw(const Sample *samples, const size_t n, std::string *predictions) const {
+    for (auto i = 0u; i < n; i++) predictions[i] = predict_raw(samples[i]);
+  }
+
+  // As predict_double_raw, for the n samples starting at samples: found tells if each prediction is available.
+  virtual void predict_double_block_raw(const Sample *samples, const size_t n, double *predictions,
+                                        uint8_t *found) const {
+    for (auto i = 0u; i < n; i++) found[i] = predict_double_raw(samples[i], predictions[i]);
+  }
+
+  // Rough estimate of the work needed to score a sample, in number of predicates or terms evaluated. It is used to
+  // decide whether the segments of an ensemble are worth splitting among threads.
+  virtual size_t cost() const { return 1; }
+
+  // Class id of the prediction of the model, -1 when the model doesn't produce any.
+  virtual int predict_class_raw(const Sample &sample) const {
+    auto class_id = class_ids.find(predict_raw(sample));
+
+    return class_id == class_ids.cend() ? -1 : class_id->second;
+  }
+
+  inline int add_class(const std::string &raw_class) {
+    auto class_id = class_ids.insert(std::make_pair(raw_class, int(class_table.size())));
+    if (class_id.second) {
+      class_table.push_back(raw_class);
+      predicted_classes.push_back(target(raw_class));
+      class_labels.push_back(labels->add(raw_class));
+    }
+
+    return class_id.first->second;
+  }
+
   InternalModel(const InternalModel &) = default;
 
   InternalModel(InternalModel &&) = default;
@@ -7,7 +7,11 @@
 #ifndef CPMML_SCORE_H
 #define CPMML_SCORE_H
 
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "core/labeltable.h"
 #include "core/value.h"
 #include "utils/utils.h"
 
@@ -19,38 +23,69 @@
  *
  * It contains both double and literal representations of the score, as well as
  * the associated probabilities and all values produced by Output.
+ *
+ * Probabilities are stored in a dense vector indexed by the ids of the
+ * LabelTable of the model: ids beyond the end of the vector, or holding
+ * double_min(), have no probability. In the same way, outputs are stored in vectors
+ * indexed by the ids of the output names of OutputDictionary. The tables are
+ * shared with the model, so that a score never copies a label.
  */
 class InternalScore {
  public:
   bool empty = true;
   std::string score;
   double double_score = double_min();
-  std::unordered_map<std::string, double> probabilities;
-  std::unordered_map<std::string, double> num_outputs;
-  std::unordered_map<std::string, std::string> str_outputs;
+  std::shared_ptr<const LabelTable> labels;            // labels of probabilities
+  std::vector<double> probabilities;                   // by label id
+  std::shared_ptr<const LabelTable> num_output_names;  // names of num_outputs
+  std::vector<double> num_outputs;                     // by output id
+  std::shared_ptr<const LabelTable> str_output_names;  // names of str_outputs
+  std::vector<std::string> str_outputs;                // by output id
 
   InternalScore() = default;
 
   explicit InternalScore(const double &score) : empty(false), score(std::to_string(score)), double_score(score) {}
 
   explicit InternalScore(const std::string &score) : empty(false), score(score) {
-    try {
-      double_score = ::to_double(score);
-    } catch (const cpmml::ParsingException &exception) {
-      double_score = double_min();
-    }
+    if (!try_to_double(score, double_score)) double_score = double_min();
+  }
+
+  InternalScore(const std::string &score, const std::shared_ptr<const LabelTable> &labels,
+                const std::vector<double> &probabilities)
+      : empty(false), score(score), labels(labels), probabilities(probabilities) {
+    if (!try_to_double(score, double_score)) double_score = double_min();
+  }
+
+  inline bool has_probability(const uint32_t label) const {
+    return label < probabilities.size() && probabilities[label] != double_min();
   }
 
-  InternalScore(const double &score, const std::unordered_map<std::string, double> &probabilities)
-      : empty(false), score(std::to_string(score)), double_score(score), probabilities(probabilities) {}
+  inline double probability(const uint32_t label) const { return has_probability(label) ? probabilities[label] : 0; }
+
+  // Sets the probability of label, growing the vector when needed
+  inline void set_probability(const uint32_t label, const double value) {
+    if (label >= probabilities.size()) probabilities.resize(label + 1, double_min());
+    probabilities[label] = value;
+  }
+
+  inline void remove_probability(const uint32_t label) {
+    if (label < probabilities.size()) probabilities[label] = double_min();
+  }
+
+  // Overwrites the score in place, keeping the memory already allocated. Outputs are left untouched, since they are
+  // overwritten field by field when added.
+  inline void assign(const std::string &value) {
+    empty = false;
+    score = value;
+    if (!try_to_double(score, double_score)) double_score = double_min();
+  }
 
-  InternalScore(const std::string &score, const std::unordered_map<std::string, double> &probabilities)
-      : empty(false), score(score), probabilities(probabilities) {
-    try {
-      double_score = ::to_double(score);
-    } catch (const cpmml::ParsingException &exception) {
-      double_score = double_min();
-    }
+  inline void assign(const InternalScore &other) {
+    empty = other.empty;
+    score = other.score;
+    double_score = other.double_score;
+    labels = other.labels;
+    probabilities.assign(other.probabilities.cbegin(), other.probabilities.cend());
   }
 
   InternalScore(const InternalScore &) = default;
@@ -15,6 +15,10 @@
  *
  * Class used to build the constraints for continous features of the
  * DataDictionary. See also Closure.
+ *
+ * An Interval is built as the AND of a lower and an upper bound, which
+ * PredicateProgram evaluates as a single range check. A missing margin leaves
+ * the interval unbounded on that side.
  */
 class IntervalBuilder {
  public:
@@ -23,10 +27,12 @@ class IntervalBuilder {
     std::vector<Predicate> tmp_constraints;
 
     Closure closure(node.get_attribute("closure"));
-    Value left_margin = node.exists_attribute("leftMargin") ? Value(node.get_attribute("leftMargin"), dataType)
-                                                            : Value(std::numeric_limits<double>::max(), dataType);
-    Value right_margin = node.exists_attribute("rightMargin") ? Value(node.get_attribute("rightMargin"), dataType)
-                                                              : Value(std::numeric_limits<double>::max(), dataType);
+    Value left_margin = node.exists_attribute("leftMargin")
+                            ? Value(node.get_attribute("leftMargin"), dataType)
+                            : Value(-std::numeric_limits<double>::infinity(), dataType);
+    Value right_margin = node.exists_attribute("rightMargin")
+                             ? Value(node.get_attribute("rightMargin"), dataType)
+                             : Value(std::numeric_limits<double>::infinity(), dataType);
     switch (closure.value) {
       case Closure::ClosureValue::CLOSED_CLOSED:
         tmp_constraints.push_back(Predicate(index, "greaterOrEqual", left_margin));
@@ -0,0 +1,58 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_LABELTABLE_H
+#define CPMML_LABELTABLE_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @class LabelTable
+ *
+ * Table of labels identified by dense ids, in order of insertion.
+ *
+ * It is owned by the model and filled while loading: InternalScore refers to
+ * it, so that probabilities and outputs are stored in vectors indexed by id
+ * rather than in maps keyed by label. Each model has one table for the
+ * classes of its probability distributions, while OutputDictionary has one for
+ * the names of its numeric outputs and one for its string outputs.
+ */
+class LabelTable {
+ public:
+  enum : uint32_t { none = std::numeric_limits<uint32_t>::max() };
+
+  std::vector<std::string> labels;  // labels by id
+
+  LabelTable() = default;
+
+  inline size_t size() const { return labels.size(); }
+
+  inline const std::string &operator[](const uint32_t id) const { return labels[id]; }
+
+  // Id of label, added to the table if not present
+  inline uint32_t add(const std::string &label) {
+    auto id = ids.insert(std::make_pair(label, uint32_t(labels.size())));
+    if (id.second) labels.push_back(label);
+
+    return id.first->second;
+  }
+
+  // Id of label, none if not present
+  inline uint32_t find(const std::string &label) const {
+    auto id = ids.find(label);
+
+    return id == ids.cend() ? none : id->second;
+  }
+
+ private:
+  std::unordered_map<std::string, uint32_t> ids;
+};
+
+#endif
@@ -112,6 +112,29 @@ class MiningField : public DataField {
 
   inline bool is_invalid(const Value &value) const { return !constraints(value); }
 
+  inline Value treat(const Value &value) const {
+    Value result;
+    if (!treat(value, result)) throw cpmml::InvalidValueException("Invalid value for field: " + name);
+
+    return result;
+  }
+
+  // As treat, but an invalid value to be returned as such is signalled through the return value
+  inline bool treat(const Value &value, Value &result) const {
+    result = value;
+    if (hasInvalidTreatment && is_invalid(value)) {
+      if (invalidvalue_treatmentmethod.value ==
+          InvalidValueTreatmentMethod::InvalidValueTreatmentMethodValue::RETURN_INVALID)
+        return false;
+      result = handle_invalid(value);
+    }
+
+    if (hasOutlierTreatment)
+      if (is_outlier(value)) result = handle_outlier(value);
+
+    return true;
+  }
+
   inline Value handle_invalid(const Value &value) const {
     switch (invalidvalue_treatmentmethod.value) {
       case InvalidValueTreatmentMethod::InvalidValueTreatmentMethodValue::RETURN_INVALID:
@@ -9,6 +9,7 @@
 
 #include <unordered_map>
 
+#include "batchbinding.h"
 #include "datafield.h"
 #include "miningfield.h"
 
@@ -65,41 +66,84 @@ class MiningSchema {
 #ifdef DEBUG
     std::cout << "BEFORE MINING SCHEMA PREPARATION: " << sample << std::endl;
 #endif
+    Value value;
     for (const auto &miningfield : miningfields) {
-      if (miningfield.index != target_index) {
-        try {
-          sample.change_value(miningfield.index, miningfield.createValue(input.at(miningfield.name)));
-          if (miningfield.hasInvalidTreatment || miningfield.hasOutlierTreatment) {
-            Value tmp_value = sample.operator[](miningfield.index).value;
-            if (miningfield.hasInvalidTreatment)
-              if (miningfield.is_invalid(tmp_value))
-                sample.change_value(miningfield.index, miningfield.handle_invalid(tmp_value));
-
-            if (miningfield.hasOutlierTreatment)
-              if (miningfield.is_outlier(tmp_value))
-                sample.change_value(miningfield.index, miningfield.handle_outlier(tmp_value));
-          }
-
-        } catch (const std::out_of_range &exception) {  // field is missing
-          sample.change_value(miningfield.index, miningfield.handle_missing());
-        } catch (const cpmml::Exception &exception) {  // field cannot be converted to double
-                                                       // because is missing
-          sample.change_value(miningfield.index, miningfield.handle_missing());
-        }
-      }
+      if (miningfield.index == target_index) continue;
+
+      const auto field = input.find(miningfield.name);
+      // a field absent or which cannot be converted to double is missing
+      if (field != input.cend() && miningfield.try_createValue(field->second, value))
+        prepare(sample, miningfield, value);
+      else
+        sample.change_value(miningfield.index, miningfield.handle_missing());
     }
 #ifdef DEBUG
     std::cout << "AFTER MINING SCHEMA PREPARATION: " << sample << std::endl;
 #endif
   }
 
-  bool validate(const Sample &sample) const {
-    for (const auto &mining_field : miningfields) {
-      if (mining_field.index == target_index) continue;
-      if (!mining_field.validate(sample)) return false;
+  const void prepare(Sample &sample, const BatchBinding &binding, const size_t &row) const {
+    for (const auto &column : binding.columns) {
+      Value value = column.value(row);
+      if (value.missing)
+        sample.change_value(column.miningfield->index, column.miningfield->handle_missing());
+      else
+        prepare(sample, *column.miningfield, value);
+    }
+
+    for (const auto &miningfield : binding.unbound)
+      sample.change_value(miningfield->index, miningfield->handle_missing());
+  }
+
+  const void prepare(Sample &sample, const cpmml::Input &input) const {
+    Value value;
+    const std::vector<cpmml::Input::Field> &fields = input.fields();
+    for (const auto &miningfield : miningfields) {
+      if (miningfield.index == target_index) continue;
+
+      if (miningfield.index >= fields.size()) {  // field never set
+        sample.change_value(miningfield.index, miningfield.handle_missing());
+        continue;
+      }
+
+      const cpmml::Input::Field &field = fields[miningfield.index];
+      switch (field.kind) {
+        case cpmml::Input::Kind::NUMERIC:
+          if (miningfield.datatype == DataType::DataTypeValue::STRING)
+            throw cpmml::InvalidValueException("Field " + miningfield.name +
+                                               " is categorical but was provided as numeric");
+          prepare(sample, miningfield, Value(field.number));
+          break;
+        case cpmml::Input::Kind::STRING:
+          if (miningfield.try_createValue(field.string, value))
+            prepare(sample, miningfield, value);
+          else  // field cannot be converted to double because is missing
+            sample.change_value(miningfield.index, miningfield.handle_missing());
+          break;
+        default:
+          sample.change_value(miningfield.index, miningfield.handle_missing());
+      }
+    }
+  }
+
+  inline void prepare(Sample &sample, const MiningField &miningfield, const Value &value) const {
+    Value treated;
+    if (miningfield.treat(value, treated))
+      sample.change_value(miningfield.index, treated);
+    else  // invalid value to be returned, treated as missing
+      sample.change_value(miningfield.index, miningfield.handle_missing());
+  }
+
+  bool validate(const Sample &sample) const { return find_invalid(sample) == miningfields.size(); }
+
+  // Position in miningfields of the first field not passing validation, miningfields.size() if there is none
+  size_t find_invalid(const Sample &sample) const {
+    for (auto i = 0u; i < miningfields.size(); i++) {
+      if (miningfields[i].index == target_index) continue;
+      if (!miningfields[i].validate(sample)) return i;
     }
 
-    return true;
+    return miningfields.size();
   }
 };
 
@@ -15,9 +15,12 @@
 #include "ensemblemodel/ensembleevaluator.h"
 #include "header.h"
 #include "internal_evaluator.h"
+#include "stringdictionary.h"
 #include "regressionmodel/regressionevaluator.h"
+#include "snapshot.h"
 #include "treemodel/treeevaluator.h"
 #include "treemodel/treemodel.h"
+#include "utils/xmlbuffer.h"
 #include "xmlnode.h"
 
 /**
@@ -28,10 +31,46 @@
 class ModelBuilder {
  public:
   inline static std::unique_ptr<InternalEvaluator> build(const std::string &filename, const bool zipped) {
-    std::vector<char> file_data = read_file(filename, zipped);
+    XmlBuffer buffer = read_file(filename, zipped);
     rapidxml::xml_document<> document;
-    document.parse<0>(file_data.data());
+    document.parse<0>(buffer.data());
+
+    return build(document);
+  }
+
+  // As build, for a document of size bytes at data
+  inline static std::unique_ptr<InternalEvaluator> build(const char *data, const size_t size, const bool zipped) {
+    XmlBuffer buffer = read_buffer(data, size, zipped);
+    rapidxml::xml_document<> document;
+    document.parse<0>(buffer.data());
+
+    return build(document);
+  }
+
+  // As build, but the document is loaded from a Snapshot rather than parsed
+  inline static std::unique_ptr<InternalEvaluator> build_from_snapshot(const std::string &filename) {
+    Snapshot snapshot(filename);
+    rapidxml::xml_document<> document;
+    snapshot.load(document);
+
+    return build(document);
+  }
+
+  // Writes the Snapshot of the model, once checked that it can be built
+  inline static void compile(const std::string &filename, const bool zipped, const std::string &snapshot_filename) {
+    XmlBuffer buffer = read_file(filename, zipped);
+    rapidxml::xml_document<> document;
+    document.parse<0>(buffer.data());
+
+    build(document);
+    Snapshot::write(document, snapshot_filename);
+  }
+
+ private:
+  inline static std::unique_ptr<InternalEvaluator> build(const rapidxml::xml_document<> &document) {
     XmlNode xmlNode(document.first_node("PMML"));
+    std::shared_ptr<StringDictionary> dictionary = std::make_shared<StringDictionary>();
+    StringDictionary::Loading loading(dictionary);
     std::unique_ptr<InternalEvaluator> evaluator;
     if (xmlNode.exists_child("MiningModel"))
       evaluator = make_unique<EnsembleEvaluator>(xmlNode);
@@ -42,7 +81,7 @@ class ModelBuilder {
     else
       throw cpmml::ParsingException("unsupported model type");
 
-    document.clear();
+    dictionary->freeze();
 
     return evaluator;
   }
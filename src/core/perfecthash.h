@@ -0,0 +1,116 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_PERFECTHASH_H
+#define CPMML_PERFECTHASH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "cPMML.h"
+
+/**
+ * @class PerfectHash
+ *
+ * Perfect hash function over a fixed set of keys, built with the hash and
+ * displace method.
+ *
+ * The keys are given through their 64-bit hashes, which have to be distinct,
+ * and are spread into buckets. The buckets are then placed from the largest
+ * one, each with the first displacement sending all its keys to free slots of
+ * a table twice as large as the number of keys. A lookup is thus a single
+ * probe: it returns the index of the only key which could have the given
+ * hash, and the caller compares it with the key looked up.
+ */
+class PerfectHash {
+ public:
+  enum : uint32_t { none = std::numeric_limits<uint32_t>::max() };
+
+  std::vector<uint32_t> displacements;  // displacement of each bucket
+  std::vector<uint32_t> slots;          // index of the key in each slot, none if empty
+
+  PerfectHash() = default;
+
+  explicit PerfectHash(const std::vector<uint64_t> &hashes) {
+    if (hashes.empty()) return;
+
+    size_t n_slots = 1;
+    while (n_slots < 2 * hashes.size()) n_slots <<= 1;
+    while (!build(hashes, n_slots, std::max<size_t>(1, n_slots / 8))) {
+      n_slots <<= 1;
+      if (n_slots > 64 * hashes.size()) throw cpmml::ParsingException("perfect hash: keys with the same hash");
+    }
+  }
+
+  inline bool empty() const { return slots.empty(); }
+
+  inline size_t size() const { return slots.size(); }
+
+  // Index of the only key which could have hash, none if there is none
+  inline uint32_t operator()(const uint64_t hash) const {
+    if (slots.empty()) return none;
+
+    return slots[slot(hash, displacements[mix(hash) & (displacements.size() - 1)])];
+  }
+
+ private:
+  enum : uint32_t { MAX_DISPLACEMENT = 1 << 16 };
+
+  // splitmix64 finalizer
+  inline static uint64_t mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+
+    return x ^ (x >> 31);
+  }
+
+  inline size_t slot(const uint64_t hash, const uint32_t displacement) const {
+    return mix(hash ^ ((displacement + 1) * 0x9E3779B97F4A7C15ull)) & (slots.size() - 1);
+  }
+
+  inline bool build(const std::vector<uint64_t> &hashes, const size_t n_slots, const size_t n_buckets) {
+    std::vector<std::vector<uint32_t>> buckets(n_buckets);
+    for (auto key = 0u; key < hashes.size(); key++) buckets[mix(hashes[key]) & (n_buckets - 1)].push_back(key);
+
+    std::vector<uint32_t> order(n_buckets);
+    for (auto i = 0u; i < n_buckets; i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&buckets](const uint32_t a, const uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    slots.assign(n_slots, none);
+    displacements.assign(n_buckets, 0);
+    std::vector<size_t> taken;
+    for (const auto &bucket : order) {
+      if (buckets[bucket].empty()) break;
+
+      uint32_t displacement = 0;
+      for (; displacement < MAX_DISPLACEMENT; displacement++) {
+        taken.clear();
+        for (const auto &key : buckets[bucket]) {
+          const size_t position = slot(hashes[key], displacement);
+          if (slots[position] != none || std::find(taken.cbegin(), taken.cend(), position) != taken.cend()) break;
+          taken.push_back(position);
+        }
+
+        if (taken.size() == buckets[bucket].size()) break;
+      }
+
+      if (displacement == MAX_DISPLACEMENT) {
+        slots.clear();
+        return false;
+      }
+
+      displacements[bucket] = displacement;
+      for (auto i = 0u; i < taken.size(); i++) slots[taken[i]] = buckets[bucket][i];
+    }
+
+    return true;
+  }
+};
+
+#endif
@@ -7,8 +7,6 @@
 #ifndef CPMML_PREDICATEBUILDER_H
 #define CPMML_PREDICATEBUILDER_H
 
-#define SET_THRESHOLD 150
-
 #include "datadictionary.h"
 
 #include "miningschema.h"
@@ -41,10 +39,8 @@ class PredicateBuilder {
         return Predicate(indexer->get_index(node.get_attribute("field")), node.get_attribute("operator"),
                          Value(node.get_attribute("value"), indexer->get_type(node.get_attribute("field"))));
       case PredicateType::PredicateTypeValue::SIMPLESET: {
+        // the representation used for scoring is chosen when compiled, see ValueSet
         std::vector<std::string> values = split(node.get_child("Array").value(), " ");
-        if (values.size() > SET_THRESHOLD)
-          return Predicate(indexer->get_index(node.get_attribute("field")), node.get_attribute("booleanOperator"),
-                           Value::createUnorderedValues(values, indexer->get_type(node.get_attribute("field"))));
         return Predicate(indexer->get_index(node.get_attribute("field")), node.get_attribute("booleanOperator"),
                          Value::createValues(values, indexer->get_type(node.get_attribute("field"))));
       }
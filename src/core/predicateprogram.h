@@ -0,0 +1,337 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_PREDICATEPROGRAM_H
+#define CPMML_PREDICATEPROGRAM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "predicate.h"
+#include "predicateoptype.h"
+#include "sample.h"
+#include "value.h"
+#include "valueset.h"
+
+/**
+ * @class PredicateProgram
+ *
+ * Compiled representation of one or more Predicate objects, used to evaluate
+ * them during scoring.
+ *
+ * Each predicate is lowered to a sequence of instructions in pre-order: a
+ * compound predicate is followed by the instructions of its operands, and
+ * every instruction knows where its own sequence ends, so that the evaluation
+ * can skip the operands it doesn't need. Simple predicates carry feature index
+ * and threshold inline, a lower and an upper bound on the same feature joined
+ * by AND (such as the Intervals of a DataField) collapse into a single range
+ * check, and the values of set predicates are compiled into ValueSet objects,
+ * whose representations are printed as they are compiled in DEBUG builds.
+ *
+ * Several predicates can share the same program, each one being identified by
+ * the index of its first instruction (see add).
+ *
+ * Predicates can be evaluated with two different semantics:
+ *      - operator(), same as Predicate::operator(): values are compared
+ *        regardless of whether they are missing.
+ *      - evaluate: a comparison involving a missing value is unknown, and
+ *        compound predicates follow the three-valued logic of PMML: AND is
+ *        false if any operand is false, otherwise unknown if any operand is
+ *        unknown, OR is true if any operand is true, otherwise unknown if any
+ *        operand is unknown, XOR is unknown if any operand is unknown and
+ *        SURROGATE skips unknown operands. The result is one of TRUE, FALSE
+ *        and UNKNOWN, so that missing values never cost an exception.
+ */
+class PredicateProgram {
+ public:
+  enum class OpCode : uint8_t {
+    TRUE,
+    FALSE,
+    EQUAL,
+    NOT_EQUAL,
+    GREATER_THAN,
+    GREATER_OR_EQUAL,
+    LESS_THAN,
+    LESS_OR_EQUAL,
+    RANGE_CLOSED_CLOSED,
+    RANGE_OPEN_OPEN,
+    RANGE_CLOSED_OPEN,
+    RANGE_OPEN_CLOSED,
+    IS_IN,
+    IS_NOT_IN,
+    AND,
+    OR,
+    XOR,
+    SURROGATE
+  };
+
+  struct Instruction {
+    OpCode opcode;
+    uint32_t feature;
+    uint32_t end;  // index following the last operand of the instruction
+    union {
+      double threshold;
+      double low;
+      uint32_t set;  // index in sets
+    };
+    double high;
+  };
+
+  enum Result : uint8_t { FALSE, TRUE, UNKNOWN };
+
+  std::vector<Instruction> instructions;
+  std::vector<ValueSet> sets;
+
+  PredicateProgram() = default;
+
+  explicit PredicateProgram(const Predicate &predicate) { add(predicate); }
+
+  inline bool empty() const { return instructions.empty(); }
+
+  // Compiles predicate at the end of the program, returning the index of its first instruction
+  inline uint32_t add(const Predicate &predicate) {
+    const uint32_t start = instructions.size();
+    Instruction instruction = {to_opcode(predicate.predicatetype), 0, 0, {0}, 0};
+
+    switch (instruction.opcode) {
+      case OpCode::TRUE:
+      case OpCode::FALSE:
+        break;
+      case OpCode::IS_IN:
+      case OpCode::IS_NOT_IN:
+        instruction.feature = predicate.feature;
+        instruction.set = sets.size();
+        sets.push_back(ValueSet(to_array(predicate)));
+#ifdef DEBUG
+        std::cout << "COMPILED SET PREDICATE ON FEATURE " << predicate.feature << ": " << sets.back().to_string()
+                  << std::endl;
+#endif
+        break;
+      case OpCode::AND:
+      case OpCode::OR:
+      case OpCode::XOR:
+      case OpCode::SURROGATE:
+        if (instruction.opcode == OpCode::AND && to_range(predicate, instruction)) break;
+        instructions.push_back(instruction);
+        add_operands(predicate, instruction.opcode);
+        instructions[start].end = instructions.size();
+        return start;
+      default:
+        instruction.feature = predicate.feature;
+        instruction.threshold = predicate.value.value;
+    }
+
+    instruction.end = start + 1;
+    instructions.push_back(instruction);
+
+    return start;
+  }
+
+  // Predicate::operator() semantics, see class description
+  inline bool operator()(const Sample &sample) const {
+    return empty() ||
+           run<false>(0, [&sample](const uint32_t feature) -> const Value & { return sample[feature].value; }) == TRUE;
+  }
+
+  // Evaluation against a single value, whatever the feature of the predicate
+  inline bool operator()(const Value &value) const {
+    return empty() || run<false>(0, [&value](const uint32_t feature) -> const Value & { return value; }) == TRUE;
+  }
+
+  // Missing aware evaluation of the predicate starting at instruction start, see class description
+  inline Result evaluate(const uint32_t start, const Sample &sample) const {
+    return run<true>(start, [&sample](const uint32_t feature) -> const Value & { return sample[feature].value; });
+  }
+
+ private:
+  template <bool missing_aware, class Fetch>
+  inline Result run(const uint32_t pc, const Fetch &fetch) const {
+    const Instruction &instruction = instructions[pc];
+    switch (instruction.opcode) {
+      case OpCode::TRUE:
+        return TRUE;
+      case OpCode::FALSE:
+        return FALSE;
+      case OpCode::AND:
+      case OpCode::OR:
+      case OpCode::XOR:
+      case OpCode::SURROGATE:
+        return run_compound<missing_aware>(instruction, pc, fetch);
+      default:
+        break;
+    }
+
+    const Value &value = fetch(instruction.feature);
+    if (missing_aware && value.missing) return UNKNOWN;
+
+    const double x = value.value;
+    switch (instruction.opcode) {
+      case OpCode::EQUAL:
+        return to_result(x == instruction.threshold);
+      case OpCode::NOT_EQUAL:
+        return to_result(x != instruction.threshold);
+      case OpCode::GREATER_THAN:
+        return to_result(x > instruction.threshold);
+      case OpCode::GREATER_OR_EQUAL:
+        return to_result(x >= instruction.threshold);
+      case OpCode::LESS_THAN:
+        return to_result(x < instruction.threshold);
+      case OpCode::LESS_OR_EQUAL:
+        return to_result(x <= instruction.threshold);
+      case OpCode::RANGE_CLOSED_CLOSED:
+        return to_result(x >= instruction.low && x <= instruction.high);
+      case OpCode::RANGE_OPEN_OPEN:
+        return to_result(x > instruction.low && x < instruction.high);
+      case OpCode::RANGE_CLOSED_OPEN:
+        return to_result(x >= instruction.low && x < instruction.high);
+      case OpCode::RANGE_OPEN_CLOSED:
+        return to_result(x > instruction.low && x <= instruction.high);
+      case OpCode::IS_IN:
+        return to_result(sets[instruction.set].contains(x));
+      case OpCode::IS_NOT_IN:
+        return to_result(!sets[instruction.set].contains(x));
+      default:
+        return FALSE;
+    }
+  }
+
+  template <bool missing_aware, class Fetch>
+  inline Result run_compound(const Instruction &instruction, const uint32_t pc, const Fetch &fetch) const {
+    uint32_t operand = pc + 1;
+    switch (instruction.opcode) {
+      case OpCode::AND: {
+        Result and_result = TRUE;
+        for (; operand < instruction.end; operand = instructions[operand].end) {
+          const Result result = run<missing_aware>(operand, fetch);
+          if (result == FALSE) return FALSE;
+          if (result == UNKNOWN) and_result = UNKNOWN;
+        }
+        return and_result;
+      }
+      case OpCode::OR: {
+        Result or_result = FALSE;
+        for (; operand < instruction.end; operand = instructions[operand].end) {
+          const Result result = run<missing_aware>(operand, fetch);
+          if (result == TRUE) return TRUE;
+          if (result == UNKNOWN) or_result = UNKNOWN;
+        }
+        return or_result;
+      }
+      case OpCode::XOR: {
+        if (operand == instruction.end) return FALSE;
+        const Result first = run<missing_aware>(operand, fetch);
+        if (first == UNKNOWN) return UNKNOWN;
+        for (operand = instructions[operand].end; operand < instruction.end; operand = instructions[operand].end) {
+          const Result result = run<missing_aware>(operand, fetch);
+          if (result != first) return result == UNKNOWN ? UNKNOWN : TRUE;
+        }
+        return FALSE;
+      }
+      default:  // SURROGATE, the first known operand when missing aware, any true operand otherwise
+        for (; operand < instruction.end; operand = instructions[operand].end) {
+          const Result result = run<missing_aware>(operand, fetch);
+          if (result == TRUE || (missing_aware && result == FALSE)) return result;
+        }
+        return FALSE;
+    }
+  }
+
+  inline static Result to_result(const bool value) { return value ? TRUE : FALSE; }
+
+  // Operands are compiled in order, nested predicates with the same associative operator are flattened
+  inline void add_operands(const Predicate &predicate, const OpCode &opcode) {
+    for (const auto &operand : predicate.predicates) {
+      const OpCode operand_opcode = to_opcode(operand.predicatetype);
+      Instruction range;
+      if (operand_opcode == opcode && (opcode == OpCode::AND || opcode == OpCode::OR) &&
+          !(opcode == OpCode::AND && to_range(operand, range)))
+        add_operands(operand, opcode);
+      else
+        add(operand);
+    }
+  }
+
+  // A lower and an upper bound on the same feature collapse into a single range check
+  inline static bool to_range(const Predicate &predicate, Instruction &instruction) {
+    if (predicate.predicates.size() != 2) return false;
+
+    const Predicate *lower = &predicate.predicates[0];
+    const Predicate *upper = &predicate.predicates[1];
+    if (is_lower_bound(*upper)) std::swap(lower, upper);
+    if (!is_lower_bound(*lower) || !is_upper_bound(*upper) || lower->feature != upper->feature) return false;
+
+    const bool closed_low = lower->predicatetype.value == PredicateOpType::PredicateOpTypeValue::GREATER_OR_EQUAL;
+    const bool closed_high = upper->predicatetype.value == PredicateOpType::PredicateOpTypeValue::LESS_OR_EQUAL;
+    if (closed_low)
+      instruction.opcode = closed_high ? OpCode::RANGE_CLOSED_CLOSED : OpCode::RANGE_CLOSED_OPEN;
+    else
+      instruction.opcode = closed_high ? OpCode::RANGE_OPEN_CLOSED : OpCode::RANGE_OPEN_OPEN;
+    instruction.feature = lower->feature;
+    instruction.low = lower->value.value;
+    instruction.high = upper->value.value;
+
+    return true;
+  }
+
+  inline static bool is_lower_bound(const Predicate &predicate) {
+    return predicate.predicatetype.value == PredicateOpType::PredicateOpTypeValue::GREATER_THAN ||
+           predicate.predicatetype.value == PredicateOpType::PredicateOpTypeValue::GREATER_OR_EQUAL;
+  }
+
+  inline static bool is_upper_bound(const Predicate &predicate) {
+    return predicate.predicatetype.value == PredicateOpType::PredicateOpTypeValue::LESS_THAN ||
+           predicate.predicatetype.value == PredicateOpType::PredicateOpTypeValue::LESS_OR_EQUAL;
+  }
+
+  inline static std::vector<double> to_array(const Predicate &predicate) {
+    std::vector<double> result;
+    if (predicate.is_hash_set)
+      for (const auto &value : predicate.values_hash) result.push_back(value.value);
+    else
+      for (const auto &value : predicate.values) result.push_back(value.value);
+
+    return result;
+  }
+
+  inline static OpCode to_opcode(const PredicateOpType &predicatetype) {
+    switch (predicatetype.value) {
+      case PredicateOpType::PredicateOpTypeValue::TRUE:
+        return OpCode::TRUE;
+      case PredicateOpType::PredicateOpTypeValue::FALSE:
+        return OpCode::FALSE;
+      case PredicateOpType::PredicateOpTypeValue::EQUAL:
+        return OpCode::EQUAL;
+      case PredicateOpType::PredicateOpTypeValue::NOT_EQUAL:
+        return OpCode::NOT_EQUAL;
+      case PredicateOpType::PredicateOpTypeValue::GREATER_THAN:
+        return OpCode::GREATER_THAN;
+      case PredicateOpType::PredicateOpTypeValue::GREATER_OR_EQUAL:
+        return OpCode::GREATER_OR_EQUAL;
+      case PredicateOpType::PredicateOpTypeValue::LESS_THAN:
+        return OpCode::LESS_THAN;
+      case PredicateOpType::PredicateOpTypeValue::LESS_OR_EQUAL:
+        return OpCode::LESS_OR_EQUAL;
+      case PredicateOpType::PredicateOpTypeValue::IS_IN:
+        return OpCode::IS_IN;
+      case PredicateOpType::PredicateOpTypeValue::IS_NOT_IN:
+        return OpCode::IS_NOT_IN;
+      case PredicateOpType::PredicateOpTypeValue::AND:
+        return OpCode::AND;
+      case PredicateOpType::PredicateOpTypeValue::OR:
+        return OpCode::OR;
+      case PredicateOpType::PredicateOpTypeValue::XOR:
+        return OpCode::XOR;
+      case PredicateOpType::PredicateOpTypeValue::SURROGATE:
+        return OpCode::SURROGATE;
+    }
+
+    return OpCode::FALSE;
+  }
+};
+
+#endif
@@ -40,12 +40,6 @@ class Feature {
 #ifdef DEBUG
   const std::string to_string() const { return "{\"" + name + "\": " + value.to_string() + "}"; };
 #endif
-
-  inline const Value &cvalue() const {
-    if (value.missing) throw cpmml::MissingValueException("missing value");
-
-    return value;
-  }
 };
 
 /**
@@ -68,6 +62,9 @@ class Sample {
 
   inline void change_value(const size_t &feature_index, const Value &value) { features[feature_index].value = value; }
 
+  // assignment between samples of the same size reuses the storage already allocated
+  inline void reset(const Sample &other) { features = other.features; }
+
   inline void change_value_if_missing(const size_t &feature_index, const Value &value) {
     if (features[feature_index].value.missing) {
       features[feature_index].value = value;
@@ -0,0 +1,197 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_SNAPSHOT_H
+#define CPMML_SNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cPMML.h"
+#include "rapidxml-1.13/rapidxml.hpp"
+#include "utils/mappedfile.h"
+
+/**
+ * @class Snapshot
+ *
+ * Binary image of a parsed PMML document, written by ModelBuilder::compile
+ * and loaded by ModelBuilder::build_from_snapshot. Snapshots are internal:
+ * they only spare the parsing of the document, while the model is still built
+ * from it, so they are not part of the public API.
+ *
+ * The file holds a header, the nodes of the document in preorder, their
+ * attributes, and a table of the strings used as names and values, each
+ * stored once and null-terminated. Loading maps the file in memory and links
+ * rapidxml nodes pointing straight into the mapping: there is no XML to
+ * tokenize, no entity to decode and no string to copy. The mapping must stay
+ * alive as long as the document is read.
+ *
+ * Files written by another version of the format, or on a machine with a
+ * different byte order, are rejected.
+ */
+class Snapshot {
+ public:
+  enum : uint32_t { VERSION = 1, ENDIANNESS = 0x01020304, none = 0xFFFFFFFF };
+
+  struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t n_nodes;
+    uint32_t n_attributes;
+    uint64_t strings_size;
+  };
+
+  struct NodeRecord {
+    uint32_t parent;  // none for the children of the document
+    uint32_t type;    // rapidxml::node_type
+    uint32_t name, name_size, value, value_size;
+    uint32_t first_attribute, n_attributes;
+  };
+
+  struct AttributeRecord {
+    uint32_t name, name_size, value, value_size;
+  };
+
+  explicit Snapshot(const std::string &filepath) : file(filepath) {
+    if (file.size() < sizeof(FileHeader)) throw cpmml::ParsingException("Invalid snapshot: file too short");
+
+    std::memcpy(&header, file.data(), sizeof(FileHeader));
+    if (std::memcmp(header.magic, magic(), sizeof(header.magic)) != 0)
+      throw cpmml::ParsingException("Invalid snapshot: not a cPMML snapshot");
+    if (header.version != VERSION || header.byte_order != ENDIANNESS)
+      throw cpmml::ParsingException("Invalid snapshot: version " + std::to_string(header.version) +
+                                    " not supported");
+
+    const uint64_t size = sizeof(FileHeader) + uint64_t(header.n_nodes) * sizeof(NodeRecord) +
+                          uint64_t(header.n_attributes) * sizeof(AttributeRecord) + header.strings_size;
+    if (size != file.size()) throw cpmml::ParsingException("Invalid snapshot: truncated file");
+
+    nodes = reinterpret_cast<const NodeRecord *>(file.data() + sizeof(FileHeader));
+    attributes = reinterpret_cast<const AttributeRecord *>(nodes + header.n_nodes);
+    strings = reinterpret_cast<const char *>(attributes + header.n_attributes);
+  }
+
+  // Rebuilds the document into document, whose strings point into the snapshot
+  inline void load(rapidxml::xml_document<> &document) const {
+    std::vector<rapidxml::xml_node<> *> document_nodes(header.n_nodes);
+    for (auto i = 0u; i < header.n_nodes; i++) {
+      const NodeRecord &node = nodes[i];
+      if ((node.parent != none && node.parent >= i) || node.type > rapidxml::node_pi ||
+          uint64_t(node.first_attribute) + node.n_attributes > header.n_attributes)
+        throw cpmml::ParsingException("Invalid snapshot: corrupted node " + std::to_string(i));
+
+      document_nodes[i] =
+          document.allocate_node(rapidxml::node_type(node.type), get_string(node.name, node.name_size),
+                                 get_string(node.value, node.value_size), node.name_size, node.value_size);
+      for (auto a = node.first_attribute; a < node.first_attribute + node.n_attributes; a++) {
+        const AttributeRecord &attribute = attributes[a];
+        document_nodes[i]->append_attribute(document.allocate_attribute(
+            get_string(attribute.name, attribute.name_size), get_string(attribute.value, attribute.value_size),
+            attribute.name_size, attribute.value_size));
+      }
+
+      (node.parent == none ? static_cast<rapidxml::xml_node<> *>(&document) : document_nodes[node.parent])
+          ->append_node(document_nodes[i]);
+    }
+  }
+
+  // Writes the snapshot of document to filepath
+  static void write(const rapidxml::xml_document<> &document, const std::string &filepath) {
+    Writer writer;
+    for (rapidxml::xml_node<> *child = document.first_node(); child; child = child->next_sibling())
+      writer.add(child, none);
+
+    FileHeader header;
+    std::memcpy(header.magic, magic(), sizeof(header.magic));
+    header.version = VERSION;
+    header.byte_order = ENDIANNESS;
+    header.n_nodes = writer.nodes.size();
+    header.n_attributes = writer.attributes.size();
+    header.strings_size = writer.strings.size();
+
+    std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(FileHeader));
+    file.write(reinterpret_cast<const char *>(writer.nodes.data()), writer.nodes.size() * sizeof(NodeRecord));
+    file.write(reinterpret_cast<const char *>(writer.attributes.data()),
+               writer.attributes.size() * sizeof(AttributeRecord));
+    file.write(writer.strings.data(), writer.strings.size());
+    if (!file) throw cpmml::ParsingException("Snapshot " + filepath + " cannot be written");
+  }
+
+ private:
+  MappedFile file;
+  FileHeader header;
+  const NodeRecord *nodes = nullptr;
+  const AttributeRecord *attributes = nullptr;
+  const char *strings = nullptr;
+
+  inline static const char *magic() { return "cPMMLsn"; }
+
+  // String of size characters at offset, checking that it lies in the table and is null-terminated
+  inline char *get_string(const uint32_t offset, const uint32_t size) const {
+    if (uint64_t(offset) + size >= header.strings_size || strings[offset + size] != '\0')
+      throw cpmml::ParsingException("Invalid snapshot: corrupted string table");
+
+    return const_cast<char *>(strings + offset);  // rapidxml never writes to the strings of a built document
+  }
+
+  struct Writer {
+    std::vector<NodeRecord> nodes;
+    std::vector<AttributeRecord> attributes;
+    std::vector<char> strings;
+    std::unordered_map<std::string, uint32_t> offsets;
+
+    inline void add(const rapidxml::xml_node<> *node, const uint32_t parent) {
+      const uint32_t index = checked(nodes.size());
+      NodeRecord record;
+      record.parent = parent;
+      record.type = node->type();
+      record.name_size = checked(node->name_size());
+      record.name = add(node->name(), node->name_size());
+      record.value_size = checked(node->value_size());
+      record.value = add(node->value(), node->value_size());
+      record.first_attribute = checked(attributes.size());
+      record.n_attributes = 0;
+      for (rapidxml::xml_attribute<> *attribute = node->first_attribute(); attribute;
+           attribute = attribute->next_attribute(), record.n_attributes++) {
+        AttributeRecord attribute_record;
+        attribute_record.name_size = checked(attribute->name_size());
+        attribute_record.name = add(attribute->name(), attribute->name_size());
+        attribute_record.value_size = checked(attribute->value_size());
+        attribute_record.value = add(attribute->value(), attribute->value_size());
+        attributes.push_back(attribute_record);
+      }
+      nodes.push_back(record);
+
+      for (rapidxml::xml_node<> *child = node->first_node(); child; child = child->next_sibling()) add(child, index);
+    }
+
+    // Offset of the string, added to the table if not present
+    inline uint32_t add(const char *string, const size_t size) {
+      auto offset = offsets.insert(std::make_pair(std::string(string, size), uint32_t(strings.size())));
+      if (offset.second) {
+        strings.insert(strings.end(), string, string + size);
+        strings.push_back('\0');
+        checked(strings.size());
+      }
+
+      return offset.first->second;
+    }
+
+    inline static uint32_t checked(const size_t value) {
+      if (value >= none) throw cpmml::ParsingException("Model too large for a snapshot");
+
+      return uint32_t(value);
+    }
+  };
+};
+
+#endif
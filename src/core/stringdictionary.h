@@ -0,0 +1,121 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_STRINGDICTIONARY_H
+#define CPMML_STRINGDICTIONARY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "perfecthash.h"
+
+/**
+ * @class StringDictionary
+ *
+ * Encoding of the strings of a model into dense codes.
+ *
+ * Every string appearing in the model (DataField values, predicate and
+ * regression literals, scores, constants...) gets a code while the model is
+ * loaded, in order of appearance: the code is then the internal value of the
+ * string (see Value). After loading the dictionary is frozen into a
+ * PerfectHash table, so that scoring only reads it and can be done
+ * concurrently. Strings seen for the first time during scoring are not added
+ * but get the code unseen, which doesn't match any string of the model.
+ *
+ * The dictionary of the model being loaded by the current thread is set
+ * through StringDictionary::Loading, and it is used by all the Values created
+ * from strings in the meantime. Objects converting strings during scoring,
+ * like DataField, keep a reference to it.
+ */
+class StringDictionary {
+ public:
+  enum : uint32_t { unseen = std::numeric_limits<uint32_t>::max() };
+
+  /**
+   * Scope in which the strings converted by the current thread are added to
+   * dictionary.
+   */
+  class Loading {
+   public:
+    explicit Loading(const std::shared_ptr<StringDictionary> &dictionary) : previous(current()) {
+      current() = dictionary;
+    }
+
+    ~Loading() { current() = previous; }
+
+    inline static std::shared_ptr<StringDictionary> &current() {
+      static thread_local std::shared_ptr<StringDictionary> dictionary;
+
+      return dictionary;
+    }
+
+   private:
+    std::shared_ptr<StringDictionary> previous;
+  };
+
+  StringDictionary() = default;
+
+  inline size_t size() const { return keys.size(); }
+
+  inline bool frozen() const { return is_frozen; }
+
+  // Code of value, added to the dictionary if not frozen
+  inline uint32_t encode(const std::string &value) {
+    if (is_frozen) return find(value);
+
+    auto code = codes.insert(std::make_pair(value, uint32_t(keys.size())));
+    if (code.second) keys.push_back(value);
+
+    return code.first->second;
+  }
+
+  // Code of value, unseen if not in the dictionary
+  inline uint32_t find(const std::string &value) const {
+    if (!is_frozen) {
+      auto code = codes.find(value);
+      return code == codes.cend() ? unseen : code->second;
+    }
+
+    const uint32_t code = table(std::hash<std::string>()(value));
+
+    return code != PerfectHash::none && keys[code] == value ? code : unseen;
+  }
+
+  inline const std::string &decode(const uint32_t code) const { return keys[code]; }
+
+  // Code of value in the dictionary of the model being loaded, unseen outside loading
+  inline static uint32_t encode_loading(const std::string &value) {
+    const std::shared_ptr<StringDictionary> &dictionary = Loading::current();
+
+    return dictionary ? dictionary->encode(value) : unseen;
+  }
+
+  // Build the perfect hash table: from now on, new strings are not added
+  inline void freeze() {
+    if (is_frozen) return;
+
+    std::vector<uint64_t> hashes;
+    hashes.reserve(keys.size());
+    for (const auto &key : keys) hashes.push_back(std::hash<std::string>()(key));
+    table = PerfectHash(hashes);
+    codes.clear();
+    is_frozen = true;
+  }
+
+ private:
+  bool is_frozen = false;
+  std::unordered_map<std::string, uint32_t> codes;  // used only while loading
+  std::vector<std::string> keys;                    // strings by code
+  PerfectHash table;                                // used once frozen
+};
+
+#endif
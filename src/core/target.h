@@ -10,6 +10,7 @@
 #define CPMML_SRC_CORE_TARGET_H_
 
 #include <functional>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -36,7 +37,7 @@ class CastInteger {
 
   CastInteger() = default;
   explicit CastInteger(const std::string &cast_integer) {
-    static std::unordered_map<std::string, std::function<double(const double)>> cast_integer_converter = {
+    const static std::unordered_map<std::string, std::function<double(const double)>> cast_integer_converter = {
         {"round", _round},
         {"ceiling", _ceil},
         {"floor", _floor},
@@ -63,6 +64,8 @@ class TargetValue {
   bool has_prior_probability;
   double prior_probability;
   double default_value;
+  uint32_t value_label = LabelTable::none;    // label id of value
+  uint32_t display_label = LabelTable::none;  // label id of display_value
   // TODO: Partition
 
   TargetValue()
@@ -71,17 +74,19 @@ class TargetValue {
         prior_probability(double_min()),
         default_value(double_min()) {}
 
-  TargetValue(const XmlNode &node)
+  TargetValue(const XmlNode &node, LabelTable &labels)
       : value(node.get_attribute("value")),
         has_display_value(node.exists_attribute("displayValue")),
         display_value(node.get_attribute("displayValue")),
         has_prior_probability(node.exists_attribute("priorProbability")),
         prior_probability(node.get_double_attribute("priorProbability")),
-        default_value(node.get_double_attribute("defaultValue")) {}
+        default_value(node.get_double_attribute("defaultValue")),
+        value_label(labels.add(value)),
+        display_label(has_display_value ? labels.add(display_value) : value_label) {}
 
-  static std::vector<TargetValue> to_targetvalues(std::vector<XmlNode> nodes) {
+  static std::vector<TargetValue> to_targetvalues(std::vector<XmlNode> nodes, LabelTable &labels) {
     std::vector<TargetValue> result;
-    for (const auto &node : nodes) result.push_back(TargetValue(node));
+    for (const auto &node : nodes) result.push_back(TargetValue(node, labels));
 
     return result;
   }
@@ -103,12 +108,14 @@ class Target {
   double rescale_factor = double_min();
   OpType optype;
   std::vector<TargetValue> target_values;
+  std::shared_ptr<const LabelTable> labels;  // labels of the model, see InternalModel
   std::function<void(InternalScore &)> transform_score;
 
   Target() = default;
 
   explicit Target(const XmlNode &node, const MiningSchema &mining_schema,
-                  const TransformationDictionary &transformation_dictionary, const MiningFunction &mining_fuction)
+                  const TransformationDictionary &transformation_dictionary, const MiningFunction &mining_fuction,
+                  const std::shared_ptr<LabelTable> &labels)
       : mining_function(mining_fuction),
         has_field_name(node.exists_attribute("field")),
         field_name(node.get_attribute("field")),
@@ -121,7 +128,8 @@ class Target {
         rescale_constant(node.get_double_attribute("rescaleConstant")),
         has_rescale_factor(node.exists_attribute("rescaleFactor")),
         rescale_factor(node.get_double_attribute("rescaleFactor")),
-        target_values(TargetValue::to_targetvalues(node.get_childs("TargetValue"))) {}
+        target_values(TargetValue::to_targetvalues(node.get_childs("TargetValue"), *labels)),
+        labels(labels) {}
 
   inline void operator()(InternalScore &score) const {
     switch (mining_function.value) {
@@ -136,17 +144,15 @@ class Target {
             }
           }
 
-          if (score.probabilities.find(target_value.value) == score.probabilities.cend()) {
+          if (!score.has_probability(target_value.value_label)) {
+            if (!score.labels) score.labels = labels;
+
             if (target_value.has_prior_probability) {
-              if (target_value.has_display_value) {
-                score.probabilities[target_value.display_value] = target_value.prior_probability;
-              } else {
-                score.probabilities[target_value.value] = target_value.prior_probability;
-              }
+              score.set_probability(target_value.display_label, target_value.prior_probability);
             } else {
               if (target_value.has_display_value) {
-                score.probabilities[target_value.display_value] = score.probabilities[target_value.value];
-                score.probabilities.erase(target_value.value);
+                score.set_probability(target_value.display_label, 0);
+                score.remove_probability(target_value.value_label);
               }
             }
           }
@@ -158,14 +164,7 @@ class Target {
           score.double_score = target_values[0].default_value;
           score.score = std::to_string(score.double_score);
         } else {
-          if (has_min && score.double_score < min)
-            score.double_score = min;
-          else if (has_max && score.double_score > max)
-            score.double_score = max;
-
-          if (has_rescale_factor) score.double_score *= rescale_factor;
-          if (has_rescale_constant) score.double_score += rescale_constant;
-          if (!cast.empty) score.double_score = cast(score.double_score);
+          score.double_score = (*this)(score.double_score);
 
           // score string representation must be updated accordingly
           score.score = std::to_string(score.double_score);
@@ -188,24 +187,39 @@ class Target {
         predicted_double = to_double(predicted);
         if (predicted == "")
           return std::to_string(target_values[0].default_value);
-        else {
-          if (has_min && predicted_double < min)
-            predicted_double = min;
-          else if (has_max && predicted_double > max)
-            predicted_double = max;
-
-          if (has_rescale_factor) predicted_double *= rescale_factor;
-          if (has_rescale_constant) predicted_double += rescale_constant;
-          if (!cast.empty) predicted_double = cast(predicted_double);
-
+        else
           // score string representation must be updated accordingly
-          return std::to_string(predicted_double);
-        }
+          return std::to_string((*this)(predicted_double));
         break;
     }
 
     return predicted;
   }
+
+  // Transformation of a numeric prediction, it has effect only for regression
+  inline double operator()(const double predicted) const {
+    double result = predicted;
+    if (mining_function.value != MiningFunction::MiningFunctionType::REGRESSION) return result;
+
+    if (has_min && result < min)
+      result = min;
+    else if (has_max && result > max)
+      result = max;
+
+    if (has_rescale_factor) result *= rescale_factor;
+    if (has_rescale_constant) result += rescale_constant;
+    if (!cast.empty) result = cast(result);
+
+    return result;
+  }
+
+  // Numeric prediction returned when the model doesn't produce any
+  inline double default_prediction() const {
+    if (mining_function.value == MiningFunction::MiningFunctionType::REGRESSION && !target_values.empty())
+      return target_values[0].default_value;
+
+    return double_min();
+  }
 };
 
 #endif  // CPMML_SRC_CORE_TARGET_H_
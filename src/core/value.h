@@ -23,43 +23,67 @@
 
 #include "datatype.h"
 #include "options.h"
+#include "stringdictionary.h"
 #include "utils/utils.h"
 
 /**
  * @class Value
  *
  * Internal representation of each value used by the model. For efficiency
- * reasons every type of input value is converted into double.
+ * reasons every type of input value is converted into double: strings are
+ * converted into their code in the StringDictionary of the model.
+ *
+ * Strings missing from the dictionary all share its unseen code, which matches
+ * no string of the model, and are flagged as unseen: two of them are not the
+ * same string just because they have the same code (see BuiltInFunction).
  */
 class Value {
  public:
   double value = double_min();
   bool missing = true;
+  bool unseen = false;  // string not in the StringDictionary of the model, whose value is StringDictionary::unseen
 #ifdef REGEX_SUPPORT
   std::string svalue;
 #endif
-#ifndef STRING_OPTIMIZATION
-  inline static double string_index = 0;  // zero initialized because static
-  inline static std::unordered_map<std::string, double> string_converter;
-#endif
 
+  // Truncating the double to size_t would send all the values in [0, 1) to the same bucket
   class ValueHash {
    public:
-    size_t operator()(const Value &obj) const { return static_cast<size_t>(obj.value); }
+    size_t operator()(const Value &obj) const { return std::hash<double>()(obj.value); }
   };
 
   Value() = default;
   // 3 cases: uninitialized (and missing), initialized but missing and not
   // missing (in other constructors)
-  explicit Value(const std::string &value) : value(infer_value(value)), missing(false) {}
+  explicit Value(const std::string &value)
+      : value(infer_value(value)), missing(false), unseen(this->value == StringDictionary::unseen) {}
   explicit Value(const double &value) : value(value), missing(false) {}
   Value(const double &value, const DataType &datatype) : value(value), missing(false) {}
-  Value(const std::string &value, const DataType &datatype) : value(to_double(value, datatype)), missing(false) {
+  Value(const std::string &value, const DataType &datatype)
+      : value(to_double(value, datatype)),
+        missing(false),
+        unseen(datatype == DataType::DataTypeValue::STRING && this->value == StringDictionary::unseen) {
 #ifdef REGEX_SUPPORT
     if (datatype == DataType::DataTypeValue::STRING) svalue = value;
 #endif
   }
 
+  // Value of a string already encoded with a StringDictionary
+  inline static Value encoded(const std::string &value, const uint32_t code) {
+    Value result(static_cast<double>(code));
+    result.unseen = code == StringDictionary::unseen;
+#ifdef REGEX_SUPPORT
+    result.svalue = value;
+#endif
+
+    return result;
+  }
+
+  // Value of a string encoded with dictionary, as done while scoring
+  inline static Value encoded(const std::string &value, const StringDictionary &dictionary) {
+    return encoded(value, dictionary.find(value));
+  }
+
   inline Value operator+(const Value &other) const { return Value(value + other.value); }
   inline Value operator-(const Value &other) const { return Value(value - other.value); }
   inline Value operator/(const Value &other) const { return Value(value / other.value); }
@@ -99,17 +123,32 @@ class Value {
   // Static members
   template <class CollectionT>
   inline static Value sum(const CollectionT &other) {
-    return std::accumulate(other.cbegin(), other.cend(), Value());
+    return sum(other.cbegin(), other.cend());
   }
 
   template <class CollectionT>
   inline static Value min(const CollectionT &other) {
-    return *std::min_element(other.cbegin(), other.cend());
+    return min(other.cbegin(), other.cend());
   }
 
   template <class CollectionT>
   inline static Value max(const CollectionT &other) {
-    return *std::max_element(other.cbegin(), other.cend());
+    return max(other.cbegin(), other.cend());
+  }
+
+  template <class IteratorT>
+  inline static Value sum(const IteratorT first, const IteratorT last) {
+    return std::accumulate(first, last, Value());
+  }
+
+  template <class IteratorT>
+  inline static Value min(const IteratorT first, const IteratorT last) {
+    return *std::min_element(first, last);
+  }
+
+  template <class IteratorT>
+  inline static Value max(const IteratorT first, const IteratorT last) {
+    return *std::max_element(first, last);
   }
 
   inline static Value min(const std::set<Value> &other) { return *other.cbegin(); }
@@ -147,13 +186,7 @@ class Value {
       case DataType::DataTypeValue::DOUBLE:
         return ::to_double(value);
       case DataType::DataTypeValue::STRING:
-#ifdef STRING_OPTIMIZATION
-        return static_cast<double>(std::hash<std::string>()(value));
-#else
-        if (string_converter.find(value) == string_converter.cend()) string_converter[value] = string_index++;
-        return string_converter[value];
-
-#endif
+        return StringDictionary::encode_loading(value);
     }
 
     return std::numeric_limits<double>::min();
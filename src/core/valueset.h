@@ -0,0 +1,128 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_VALUESET_H
+#define CPMML_VALUESET_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "perfecthash.h"
+
+/**
+ * @class ValueSet
+ *
+ * Set of values of a SimpleSetPredicate, compiled for membership tests.
+ *
+ * The representation is chosen once, when the set is built, according to its
+ * size and domain:
+ *      - BITSET: the values are integers in a range no wider than 64 times
+ *        the size of the set, as the codes of strings (see StringDictionary)
+ *        or integer fields usually are. A test is a single bit lookup.
+ *      - SORTED: small sets, searched by a branchless binary search.
+ *      - PERFECT_HASH: any other set, looked up through a PerfectHash table
+ *        over the bit patterns of the values, with a single probe.
+ */
+class ValueSet {
+ public:
+  enum class Representation : uint8_t { BITSET, SORTED, PERFECT_HASH };
+
+  enum : size_t { SORTED_MAX_SIZE = 32, BITSET_BITS_PER_VALUE = 64 };
+
+  Representation representation = Representation::SORTED;
+  std::vector<double> values;  // sorted values, keys of the table for PERFECT_HASH
+  double low = 0;              // value of the first bit for BITSET
+  double span = 0;             // number of bits for BITSET
+  std::vector<uint64_t> bits;
+  PerfectHash table;
+
+  ValueSet() = default;
+
+  explicit ValueSet(std::vector<double> set_values) : values(std::move(set_values)) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    if (is_bitset()) {
+      representation = Representation::BITSET;
+      low = values.front();
+      span = values.back() - low + 1;
+      bits.assign((static_cast<size_t>(span) + 63) / 64, 0);
+      for (const auto &value : values) {
+        const size_t bit = static_cast<size_t>(value - low);
+        bits[bit >> 6] |= uint64_t(1) << (bit & 63);
+      }
+      values.clear();
+    } else if (values.size() > SORTED_MAX_SIZE) {
+      representation = Representation::PERFECT_HASH;
+      std::vector<uint64_t> hashes;
+      hashes.reserve(values.size());
+      for (const auto &value : values) hashes.push_back(hash(value));
+      table = PerfectHash(hashes);
+    }
+  }
+
+  inline bool contains(const double value) const {
+    switch (representation) {
+      case Representation::BITSET: {
+        const double offset = value - low;
+        if (!(offset >= 0 && offset < span)) return false;
+        const size_t bit = static_cast<size_t>(offset);
+        return bit == offset && ((bits[bit >> 6] >> (bit & 63)) & 1);
+      }
+      case Representation::SORTED: {
+        size_t n = values.size();
+        if (n == 0) return false;
+        const double *base = values.data();
+        while (n > 1) {
+          const size_t half = n / 2;
+          base = base[half] <= value ? base + half : base;
+          n -= half;
+        }
+        return *base == value;
+      }
+      default: {
+        const uint32_t key = table(hash(value));
+        return key != PerfectHash::none && values[key] == value;
+      }
+    }
+  }
+
+  inline std::string to_string() const {
+    switch (representation) {
+      case Representation::BITSET:
+        return "bitset(span=" + std::to_string(static_cast<size_t>(span)) + ")";
+      case Representation::SORTED:
+        return "sorted(size=" + std::to_string(values.size()) + ")";
+      default:
+        return "perfect_hash(size=" + std::to_string(values.size()) + ", slots=" + std::to_string(table.size()) + ")";
+    }
+  }
+
+ private:
+  inline bool is_bitset() const {
+    if (values.empty()) return false;
+    for (const auto &value : values)
+      if (value != std::floor(value)) return false;
+
+    return values.back() - values.front() < double(BITSET_BITS_PER_VALUE) * values.size();
+  }
+
+  // Bit pattern of value, with the same hash for 0 and -0
+  inline static uint64_t hash(const double value) {
+    const double normalized = value == 0 ? 0 : value;
+    uint64_t result;
+    std::memcpy(&result, &normalized, sizeof(result));
+
+    return result;
+  }
+};
+
+#endif
@@ -24,6 +24,10 @@ class EnsembleEvaluator : public InternalEvaluator {
       : InternalEvaluator(node),
         model(node.get_child("MiningModel"), data_dictionary, transformation_dictionary, indexer){};
 
+  inline bool validate(const std::unordered_map<std::string, std::string> &sample) const override {
+    return model.validate(sample);
+  }
+
   inline std::unique_ptr<InternalScore> score(
       const std::unordered_map<std::string, std::string> &sample) const override {
     return model.score(sample);
@@ -34,6 +38,8 @@ class EnsembleEvaluator : public InternalEvaluator {
   }
 
   inline std::string get_target_name() const override { return model.target_field.name; };
+
+  inline const InternalModel &get_model() const override { return model; }
 };
 
 #endif
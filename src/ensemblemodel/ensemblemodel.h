@@ -11,6 +11,7 @@
 
 #include "core/internal_model.h"
 #include "multiplemodelmethod.h"
+#include "quickscorer.h"
 #include "regressionmodel/regressionmodel.h"
 #include "treemodel/treemodel.h"
 
@@ -23,13 +24,21 @@
  * Through this class are represented all ensemble models. For instance, the
  * Random Forest Model or the Gradient Boosted Trees model. See also
  * MultipleModelMethod.
+ *
+ * When QUICKSCORER is defined, the sum of an ensemble of regression trees is
+ * computed through QuickScorer.
  */
 class EnsembleModel : public InternalModel {
  public:
   Predicate predicate;
   MultipleModelMethod multiplemodelmethod;
   std::vector<Segment> ensemble;
+  std::vector<uint32_t> vote_labels;  // label id of each class id, followed by the one of segments with no class
+  size_t task_segments = 0;           // see MultipleModelMethod::get_task_segments
   std::function<std::unique_ptr<InternalScore>(const Sample &)> score_ensemble;
+#ifdef QUICKSCORER
+  QuickScorer quickscorer;
+#endif
 
   EnsembleModel() = default;
 
@@ -44,18 +53,108 @@ class EnsembleModel : public InternalModel {
                                  build_segment_model(child, data_dictionary, InternalModel::transformation_dictionary,
                                                      predicate_builder, indexer)));
 
-    score_ensemble = std::bind(multiplemodelmethod.function, std::placeholders::_1, ensemble);
+    if (mining_function.value == MiningFunction::MiningFunctionType::CLASSIFICATION)
+      for (auto &segment : ensemble)
+        for (const auto &segment_class : segment.model->class_table)
+          segment.class_map.push_back(add_class(segment_class));
+
+    for (auto &segment : ensemble)
+      for (const auto &segment_label : segment.model->labels->labels)
+        segment.label_map.push_back(labels->add(segment_label));
+
+    if (multiplemodelmethod.value == MultipleModelMethod::MultipleModelMethodType::MAJORITY_VOTE ||
+        multiplemodelmethod.value == MultipleModelMethod::MultipleModelMethodType::WEIGHTED_MAJORITY_VOTE) {
+      vote_labels = class_labels;
+      vote_labels.push_back(labels->add(""));
+    }
+
+    if (multiplemodelmethod.value == MultipleModelMethod::MultipleModelMethodType::MODEL_CHAIN)
+      output.include(ensemble.back().model->output);
+
+#ifdef QUICKSCORER
+    if (multiplemodelmethod.value == MultipleModelMethod::MultipleModelMethodType::SUM)
+      quickscorer = QuickScorer(ensemble);
+#endif
+
+    task_segments = MultipleModelMethod::get_task_segments(ensemble);
+    score_ensemble = std::bind(multiplemodelmethod.function, std::placeholders::_1, ensemble,
+                               std::shared_ptr<const LabelTable>(labels), vote_labels, task_segments);
     base_sample = create_basesample(indexer);
   };
 
   inline std::unique_ptr<InternalScore> score_raw(const Sample &sample) const override {
+    if (multiplemodelmethod.value == MultipleModelMethod::MultipleModelMethodType::SUM)
+      return MultipleModelMethod::to_score(get_sum(sample));
+
     return score_ensemble(sample);
   }
 
   inline std::string predict_raw(const Sample &sample) const override {
-    std::unique_ptr<InternalScore> score(score_ensemble(sample));
+    double predicted;
+    int class_id;
+
+    switch (multiplemodelmethod.value) {
+      case MultipleModelMethod::MultipleModelMethodType::MAJORITY_VOTE:
+      case MultipleModelMethod::MultipleModelMethodType::WEIGHTED_MAJORITY_VOTE:
+        class_id = predict_class_raw(sample);
+        return class_id < 0 ? std::string() : class_table[class_id];
+      case MultipleModelMethod::MultipleModelMethodType::SUM:
+        return predict_double_raw(sample, predicted) ? std::to_string(predicted) : std::string();
+      case MultipleModelMethod::MultipleModelMethodType::AVERAGE:
+        if (mining_function.value == MiningFunction::MiningFunctionType::REGRESSION)
+          return predict_double_raw(sample, predicted) ? std::to_string(predicted) : std::string();  // classification average falls back to the full score
+      default:
+        return std::unique_ptr<InternalScore>(score_ensemble(sample))->score;
+    }
+  }
+
+  inline bool predict_double_raw(const Sample &sample, double &predicted) const override {
+    switch (multiplemodelmethod.value) {
+      case MultipleModelMethod::MultipleModelMethodType::SUM:
+        predicted = get_sum(sample);
+        return predicted != double_min();
+      case MultipleModelMethod::MultipleModelMethodType::AVERAGE:
+        if (mining_function.value == MiningFunction::MiningFunctionType::REGRESSION) {
+          predicted = MultipleModelMethod::get_average(sample, ensemble, task_segments);
+          return predicted != double_min();
+        }  // classification average falls back to the parsed prediction
+      default:
+        return InternalModel::predict_double_raw(sample, predicted);
+    }
+  }
+
+  inline int predict_class_raw(const Sample &sample) const override {
+    std::vector<double> votes;
+
+    switch (multiplemodelmethod.value) {
+      case MultipleModelMethod::MultipleModelMethodType::MAJORITY_VOTE:
+        votes.assign(class_table.size() + 1, 0);
+        MultipleModelMethod::vote(sample, ensemble, task_segments, votes);
+        return MultipleModelMethod::get_winner(votes, 0.5);
+      case MultipleModelMethod::MultipleModelMethodType::WEIGHTED_MAJORITY_VOTE:
+        votes.assign(class_table.size() + 1, 0);
+        MultipleModelMethod::weighted_vote(sample, ensemble, votes);
+        return MultipleModelMethod::get_winner(votes, 1.0 / ensemble[0].model->target_field.n_values);
+      default:
+        return InternalModel::predict_class_raw(sample);
+    }
+  }
+
+  // Sum of the predictions of the segments, double_min() when any of them has no prediction
+  inline double get_sum(const Sample &sample) const {
+#ifdef QUICKSCORER
+    double result;
+    if (!quickscorer.empty() && quickscorer.sum(sample, ensemble, result)) return result;
+#endif
+
+    return MultipleModelMethod::get_sum(sample, ensemble, task_segments);
+  }
+
+  inline size_t cost() const override {
+    size_t cost = 0;
+    for (const auto &segment : ensemble) cost += segment.model->cost() + 1;
 
-    return score->score;
+    return cost;
   }
 
   static std::unique_ptr<InternalModel> build_segment_model(const XmlNode &node, const DataDictionary &data_dictionary,
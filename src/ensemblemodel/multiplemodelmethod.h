@@ -7,16 +7,14 @@
 #ifndef CPMML_MULTIPLEMODELMETHOD_H
 #define CPMML_MULTIPLEMODELMETHOD_H
 
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
-#ifdef MULTITHREADING
-#include <omp.h>
-#endif
-
 #include "core/internal_score.h"
 #include "segment.h"
+#include "utils/threadpool.h"
 #include "utils/utils.h"
 
 /**
@@ -46,8 +44,21 @@ class MultipleModelMethod {
     MODEL_CHAIN
   };
 
+  enum : size_t { TASK_COST = 8192, MIN_TASK_SEGMENTS = 8 };
+
+  // Partial result of a task, padded so that the partials of different tasks don't share a cache line
+  struct Partial {
+    double sum = 0;
+    double count = 0;
+    double missing = 0;  // segments with no prediction
+    char padding[ThreadPool::CACHE_LINE - 3 * sizeof(double)];
+  };
+
   MultipleModelMethodType value;
-  std::function<std::unique_ptr<InternalScore>(const Sample &, const std::vector<Segment> &)> function;
+  std::function<std::unique_ptr<InternalScore>(const Sample &, const std::vector<Segment> &,
+                                               const std::shared_ptr<const LabelTable> &,
+                                               const std::vector<uint32_t> &, const size_t)>
+      function;
 
   MultipleModelMethod() = default;
 
@@ -74,8 +85,10 @@ class MultipleModelMethod {
     }
   }
 
-  static std::function<std::unique_ptr<InternalScore>(const Sample &, const std::vector<Segment> &)> to_function(
-      const std::string &multiplemodelmethod, const MiningFunction &mining_function) {
+  static std::function<std::unique_ptr<InternalScore>(const Sample &, const std::vector<Segment> &,
+                                                      const std::shared_ptr<const LabelTable> &,
+                                                      const std::vector<uint32_t> &, const size_t)>
+  to_function(const std::string &multiplemodelmethod, const MiningFunction &mining_function) {
     switch (from_string(multiplemodelmethod)) {
       case MultipleModelMethodType::MAJORITY_VOTE:
         return majority_vote;
@@ -99,208 +112,240 @@ class MultipleModelMethod {
     throw cpmml::ParsingException(multiplemodelmethod + " not supported");
   }
 
-#ifndef MULTITHREADING
-
-  static std::unique_ptr<InternalScore> majority_vote(const Sample &sample, const std::vector<Segment> &ensemble) {
-    std::unordered_map<std::string, double> probabilities;  // zero initialized
-
-    std::string score;
-    for (const auto &segment : ensemble)
-      if (segment.predicate(sample)) probabilities[segment.predict(sample)] += 1.0 / ensemble.size();
-
+  // Winning class among the votes, indexed by class id. Classes are visited by id, and the first one exceeding
+  // winning_threshold wins. It returns -1 when no class has votes.
+  inline static int get_winner(const std::vector<double> &votes, const double winning_threshold) {
     double max_prob = 0;
-    for (const auto &probability : probabilities) {
-      if (max_prob > 0.5) break;
+    int winner = -1;
+    for (auto i = 0u; i + 1 < votes.size(); i++) {
+      if (max_prob > winning_threshold) break;
 
-      if (probability.second > max_prob && probability.first != "") {
-        max_prob = probability.second;
-        score = probability.first;
+      if (votes[i] > max_prob) {
+        max_prob = votes[i];
+        winner = i;
       }
     }
 
-    return make_unique<InternalScore>(score, probabilities);
+    return winner;
   }
 
-#else
-  inline static std::unique_ptr<InternalScore> majority_vote(const Sample &sample,
-                                                             const std::vector<Segment> &ensemble) {
-    std::unordered_map<std::string, double> probabilities;  // zero initialized
-    std::unordered_map<std::string, double> tmp_probabilities[NUM_THREADS];
-
-    std::string score;
-#pragma omp parallel for if (ensemble.size() > 25) default(shared) num_threads(NUM_THREADS)
-    for (auto i = 0u; i < ensemble.size(); i++)
-      if (ensemble[i].predicate(sample))
-        tmp_probabilities[omp_get_thread_num()][ensemble[i].predict(sample)] += 1.0 / ensemble.size();
+  // Score of the votes: vote_labels holds the label id of each class id, followed by the one of segments not predicting
+  // any class
+  inline static std::unique_ptr<InternalScore> to_score(const std::vector<double> &votes, const int winner,
+                                                        const std::shared_ptr<const LabelTable> &labels,
+                                                        const std::vector<uint32_t> &vote_labels) {
+    std::vector<double> probabilities(labels->size(), double_min());
+    for (auto i = 0u; i < votes.size(); i++)
+      if (votes[i] > 0) probabilities[vote_labels[i]] = votes[i];
+
+    return make_unique<InternalScore>(winner < 0 ? std::string() : (*labels)[vote_labels[winner]], labels,
+                                      probabilities);
+  }
 
-    for (auto i = 0u; i < NUM_THREADS; i++)
-      for (const auto &pair : tmp_probabilities[i]) probabilities[pair.first] += pair.second;
+  // Score of a regression, with no prediction when prediction is double_min()
+  inline static std::unique_ptr<InternalScore> to_score(const double prediction) {
+    return prediction == double_min() ? make_unique<InternalScore>() : make_unique<InternalScore>(prediction);
+  }
 
-    double max_prob = 0;
-    for (const auto &probability : probabilities) {
-      if (max_prob > 0.5) break;
+  inline static std::unique_ptr<InternalScore> majority_vote(const Sample &sample, const std::vector<Segment> &ensemble,
+                                                             const std::shared_ptr<const LabelTable> &labels,
+                                                             const std::vector<uint32_t> &vote_labels,
+                                                             const size_t task_segments) {
+    std::vector<double> votes(vote_labels.size(), 0);
+    vote(sample, ensemble, task_segments, votes);
 
-      if (probability.second > max_prob && probability.first != "") {
-        max_prob = probability.second;
-        score = probability.first;
-      }
-    }
-
-    return make_unique<InternalScore>(score, probabilities);
+    return to_score(votes, get_winner(votes, 0.5), labels, vote_labels);
   }
 
-#endif
+  // Votes of the segments, indexed by class id: the last element holds the votes of segments not predicting any class.
+  // With task_segments > 0, the segments are split among the tasks of a job of the ThreadPool, task_segments each.
+  inline static void vote(const Sample &sample, const std::vector<Segment> &ensemble, const size_t task_segments,
+                          std::vector<double> &votes) {
+    if (task_segments == 0) return vote(sample, ensemble, 0, ensemble.size(), votes.data(), votes.size());
+
+    // rows of different tasks are one cache line apart
+    const size_t stride = votes.size() + ThreadPool::CACHE_LINE / sizeof(double);
+    const size_t n_tasks = (ensemble.size() + task_segments - 1) / task_segments;
+    std::vector<double> task_votes(n_tasks * stride, 0);
+    ThreadPool::instance().run(n_tasks, [&](const size_t task) {
+      vote(sample, ensemble, task * task_segments, std::min(ensemble.size(), (task + 1) * task_segments),
+           &task_votes[task * stride], votes.size());
+    });
+
+    for (auto task = 0u; task < n_tasks; task++)
+      for (auto i = 0u; i < votes.size(); i++) votes[i] += task_votes[task * stride + i];
+  }
 
-  inline static std::unique_ptr<InternalScore> weighted_majority_vote(const Sample &sample,
-                                                                      const std::vector<Segment> &ensemble) {
-    std::unordered_map<std::string, double> probabilities;  // zero initialized
+  inline static void vote(const Sample &sample, const std::vector<Segment> &ensemble, const size_t first,
+                          const size_t last, double *votes, const size_t n_votes) {
+    for (auto i = first; i < last; i++)
+      if (ensemble[i].predicate(sample)) votes[ensemble[i].predict_class(sample, n_votes - 1)] += 1.0 / ensemble.size();
+  }
 
+  inline static void weighted_vote(const Sample &sample, const std::vector<Segment> &ensemble,
+                                   std::vector<double> &votes) {
     for (const auto &segment : ensemble)
-      if (segment.predicate(sample)) probabilities[segment.predict(sample)] += 1.0 * segment.weight / ensemble.size();
-
-    double max_prob = 0;
-    std::string score;
-    double winning_threshold = 1.0 / ensemble[0].model->target_field.n_values;
-    for (const auto &probability : probabilities) {
-      if (max_prob > winning_threshold) break;
-
-      if (probability.second > max_prob && probability.first != "") {
-        max_prob = probability.second;
-        score = probability.first;
-      }
-    }
+      if (segment.predicate(sample))
+        votes[segment.predict_class(sample, votes.size() - 1)] += 1.0 * segment.weight / ensemble.size();
+  }
 
-    return make_unique<InternalScore>(score, probabilities);
+  inline static std::unique_ptr<InternalScore> weighted_majority_vote(const Sample &sample,
+                                                                      const std::vector<Segment> &ensemble,
+                                                                      const std::shared_ptr<const LabelTable> &labels,
+                                                                      const std::vector<uint32_t> &vote_labels,
+                                                                      const size_t task_segments) {
+    std::vector<double> votes(vote_labels.size(), 0);
+    weighted_vote(sample, ensemble, votes);
+
+    return to_score(votes, get_winner(votes, 1.0 / ensemble[0].model->target_field.n_values), labels, vote_labels);
   }
 
   inline static std::unique_ptr<InternalScore> classification_average(const Sample &sample,
-                                                                      const std::vector<Segment> &ensemble) {
-    std::unique_ptr<InternalScore> first_score(ensemble[0].score(sample));
-    std::unordered_map<std::string, double> probabilities = first_score->probabilities;
+                                                                      const std::vector<Segment> &ensemble,
+                                                                      const std::shared_ptr<const LabelTable> &labels,
+                                                                      const std::vector<uint32_t> &vote_labels,
+                                                                      const size_t task_segments) {
+    std::vector<double> probabilities(labels->size(), double_min());
+    accumulate(*ensemble[0].score(sample), ensemble[0], 1, probabilities);
 
     for (auto i = 1u; i < ensemble.size(); i++)
-      if (ensemble[i].predicate(sample)) {
-        std::unique_ptr<InternalScore> tmp_score(ensemble[i].score(sample));
-        for (const auto &probability : tmp_score->probabilities) probabilities[probability.first] += probability.second;
+      if (ensemble[i].predicate(sample)) accumulate(*ensemble[i].score(sample), ensemble[i], 1, probabilities);
+
+    return average(probabilities, ensemble.size(), 1.0, labels);
+  }
+
+  // Adds the probabilities of the score of segment, multiplied by weight, to the ones of the ensemble
+  inline static void accumulate(const InternalScore &score, const Segment &segment, const double weight,
+                                std::vector<double> &probabilities) {
+    for (auto i = 0u; i < score.probabilities.size(); i++)
+      if (score.has_probability(i)) {
+        double &probability = probabilities[segment.label_map[i]];
+        probability = (probability == double_min() ? 0 : probability) + score.probabilities[i] * weight;
       }
+  }
 
-    for (const auto &probability : probabilities)
-      probabilities[probability.first] = probability.second / ensemble.size();
+  // Score averaging the accumulated probabilities. Labels are visited by id, and the first one reaching
+  // winning_threshold wins.
+  inline static std::unique_ptr<InternalScore> average(std::vector<double> &probabilities, const size_t n_segments,
+                                                       const double winning_threshold,
+                                                       const std::shared_ptr<const LabelTable> &labels) {
+    for (auto &probability : probabilities)
+      if (probability != double_min()) probability /= n_segments;
 
     double max_prob = 0;
     std::string score;
-    double winning_threshold = 1.0;  // / ensemble[0].model->target_field.n_values;
-    for (const auto &probability : probabilities) {
+    for (auto i = 0u; i < probabilities.size(); i++) {
       if (max_prob >= winning_threshold) break;
 
-      if (probability.second > max_prob && probability.first != "") {
-        max_prob = probability.second;
-        score = probability.first;
+      if (probabilities[i] != double_min() && probabilities[i] > max_prob && !(*labels)[i].empty()) {
+        max_prob = probabilities[i];
+        score = (*labels)[i];
       }
     }
 
-    return make_unique<InternalScore>(score, probabilities);
+    return make_unique<InternalScore>(score, labels, probabilities);
   }
 
-#ifndef MULTITHREADING
-  static std::unique_ptr<InternalScore> regression_average(const Sample &sample, const std::vector<Segment> &ensemble) {
-    double score = 0;
-    double count = 0;
-
-    for (const auto &segment : ensemble)
-      if (segment.predicate(sample)) {
-        count++;
-        score += to_double(segment.predict(sample));
-      }
-
-    score /= count;
-
-    return make_unique<InternalScore>(score);
-  }
-#else
   inline static std::unique_ptr<InternalScore> regression_average(const Sample &sample,
-                                                                  const std::vector<Segment> &ensemble) {
-    double score = 0;
-    double scores[NUM_THREADS];
-    double count = 0;
-
-    for (auto i = 0u; i < NUM_THREADS; i++) scores[i] = 0;
-
-#pragma omp parallel for if (ensemble.size() > 25) default(shared) num_threads(NUM_THREADS)
-    for (auto i = 0u; i < ensemble.size(); i++)
-      if (ensemble[i].predicate(sample)) {
-        count++;
-        scores[omp_get_thread_num()] += to_double(ensemble[i].predict(sample));
-      }
-
-    for (auto i = 0u; i < NUM_THREADS; i++) score += scores[i];
+                                                                  const std::vector<Segment> &ensemble,
+                                                                  const std::shared_ptr<const LabelTable> &labels,
+                                                                  const std::vector<uint32_t> &vote_labels,
+                                                                  const size_t task_segments) {
+    return to_score(get_average(sample, ensemble, task_segments));
+  }
 
-    score /= count;
+  // Average of the predictions of the segments, double_min() when any of them has no prediction
+  inline static double get_average(const Sample &sample, const std::vector<Segment> &ensemble,
+                                   const size_t task_segments) {
+    const Partial total = add_predictions(sample, ensemble, task_segments);
 
-    return make_unique<InternalScore>(score);
+    return total.missing > 0 ? double_min() : total.sum / total.count;
   }
-#endif
 
-  inline static std::unique_ptr<InternalScore> classification_weighted_average(const Sample &sample,
-                                                                               const std::vector<Segment> &ensemble) {
-    std::unique_ptr<InternalScore> first_score(ensemble[0].score(sample));
-    std::unordered_map<std::string, double> probabilities = first_score->probabilities;
+  inline static std::unique_ptr<InternalScore> classification_weighted_average(
+      const Sample &sample, const std::vector<Segment> &ensemble, const std::shared_ptr<const LabelTable> &labels,
+      const std::vector<uint32_t> &vote_labels, const size_t task_segments) {
+    std::vector<double> probabilities(labels->size(), double_min());
+    accumulate(*ensemble[0].score(sample), ensemble[0], 1, probabilities);
 
     for (auto i = 1u; i < ensemble.size(); i++)
-      if (ensemble[i].predicate(sample)) {
-        std::unique_ptr<InternalScore> tmp_score(ensemble[i].score(sample));
-        for (const auto &probability : tmp_score->probabilities)
-          probabilities[probability.first] += probability.second * ensemble[i].weight;
-      }
-
-    for (const auto &probability : probabilities)
-      probabilities[probability.first] = probability.second / ensemble.size();
-
-    double max_prob = 0;
-    std::string score;
-    double winning_threshold = 1.0 / ensemble[0].model->target_field.n_values;
-    for (const auto &probability : probabilities) {
-      if (max_prob >= winning_threshold) break;
+      if (ensemble[i].predicate(sample))
+        accumulate(*ensemble[i].score(sample), ensemble[i], ensemble[i].weight, probabilities);
 
-      if (probability.second > max_prob && probability.first != "") {
-        max_prob = probability.second;
-        score = probability.first;
-      }
-    }
+    return average(probabilities, ensemble.size(), 1.0 / ensemble[0].model->target_field.n_values, labels);
+  }
 
-    return make_unique<InternalScore>(score, probabilities);
+  inline static std::unique_ptr<InternalScore> sum(const Sample &sample, const std::vector<Segment> &ensemble,
+                                                   const std::shared_ptr<const LabelTable> &labels,
+                                                   const std::vector<uint32_t> &vote_labels,
+                                                   const size_t task_segments) {
+    return to_score(get_sum(sample, ensemble, task_segments));
   }
 
-#ifndef MULTITHREADING
+  // Sum of the predictions of the segments, double_min() when any of them has no prediction
+  inline static double get_sum(const Sample &sample, const std::vector<Segment> &ensemble, const size_t task_segments) {
+    const Partial total = add_predictions(sample, ensemble, task_segments);
 
-  inline static std::unique_ptr<InternalScore> sum(const Sample &sample, const std::vector<Segment> &ensemble) {
-    double score = 0;
+    return total.missing > 0 ? double_min() : total.sum;
+  }
 
-    for (const auto &segment : ensemble)
-      if (segment.predicate(sample)) score += std::unique_ptr<InternalScore>(segment.score(sample))->double_score;
+  // Sum of the predictions of the segments whose predicate is true, along with their count and the number of segments
+  // with no prediction. As for vote, with
+  // task_segments > 0 the segments are split among the tasks of a job of the ThreadPool. Partial results are added in
+  // the order of the tasks, so that the result doesn't depend on the number of threads.
+  inline static Partial add_predictions(const Sample &sample, const std::vector<Segment> &ensemble,
+                                        const size_t task_segments) {
+    if (task_segments == 0) return add_predictions(sample, ensemble, 0, ensemble.size());
+
+    const size_t n_tasks = (ensemble.size() + task_segments - 1) / task_segments;
+    std::vector<Partial> partials(n_tasks);
+    ThreadPool::instance().run(n_tasks, [&](const size_t task) {
+      partials[task] =
+          add_predictions(sample, ensemble, task * task_segments, std::min(ensemble.size(), (task + 1) * task_segments));
+    });
+
+    Partial total;
+    for (const auto &partial : partials) {
+      total.sum += partial.sum;
+      total.count += partial.count;
+      total.missing += partial.missing;
+    }
 
-    return make_unique<InternalScore>(score);
+    return total;
   }
 
-#else
-  inline static std::unique_ptr<InternalScore> sum(const Sample &sample, const std::vector<Segment> &ensemble) {
-    double score = 0;
-    double scores[NUM_THREADS];
+  inline static Partial add_predictions(const Sample &sample, const std::vector<Segment> &ensemble, const size_t first,
+                                        const size_t last) {
+    Partial partial;
+    for (auto i = first; i < last; i++)
+      if (ensemble[i].predicate(sample)) {
+        const double prediction = ensemble[i].predict_double(sample);
+        if (prediction == double_min())
+          partial.missing++;
+        else
+          partial.sum += prediction;
+        partial.count++;
+      }
 
-    for (auto i = 0u; i < NUM_THREADS; i++) scores[i] = 0;
+    return partial;
+  }
 
-#pragma omp parallel for if (ensemble.size() > 25) default(shared) num_threads(NUM_THREADS)
-    for (auto i = 0u; i < ensemble.size(); i++)
-      if (ensemble[i].predicate(sample))
-        scores[omp_get_thread_num()] += std::unique_ptr<InternalScore>(ensemble[i].score(sample))->double_score;
+  // Number of segments scored by each task when the segments of ensemble are split among threads, 0 when the ensemble
+  // is too cheap to be split: each task has to amount to at least TASK_COST (see InternalModel::cost).
+  static size_t get_task_segments(const std::vector<Segment> &ensemble) {
+    size_t cost = 0;
+    for (const auto &segment : ensemble) cost += segment.model->cost();
+    if (cost == 0) return 0;
 
-    for (auto i = 0u; i < NUM_THREADS; i++) score += scores[i];
+    const size_t task_segments = std::max<size_t>(MIN_TASK_SEGMENTS, (TASK_COST * ensemble.size() + cost - 1) / cost);
 
-    return make_unique<InternalScore>(score);
+    return task_segments < ensemble.size() ? task_segments : 0;
   }
-#endif
 
-  inline static std::unique_ptr<InternalScore> model_chain(const Sample &sample, const std::vector<Segment> &ensemble) {
+  inline static std::unique_ptr<InternalScore> model_chain(const Sample &sample, const std::vector<Segment> &ensemble,
+                                                           const std::shared_ptr<const LabelTable> &labels,
+                                                           const std::vector<uint32_t> &vote_labels,
+                                                           const size_t task_segments) {
     Sample tmp_sample = sample;
     bool first = true;
 
@@ -314,7 +359,10 @@ class MultipleModelMethod {
         }
       }
 
-    return ensemble.back().model->augment_last(tmp_sample);
+    std::unique_ptr<InternalScore> score = ensemble.back().model->augment_last(tmp_sample);
+    ensemble.back().relabel(*score, labels);
+
+    return score;
   }
 };
 
@@ -0,0 +1,254 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_QUICKSCORER_H
+#define CPMML_QUICKSCORER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "core/predicateprogram.h"
+#include "segment.h"
+#include "treemodel/treemodel.h"
+
+/**
+ * @class QuickScorer
+ *
+ * Bitvector based evaluation of the sum of an ensemble of regression trees,
+ * following the QuickScorer algorithm (Lucchese et al., 2015).
+ *
+ * Each TreeModel is seen as a binary tree, where every node but the root tests
+ * its own predicate: when the test succeeds the node is visited, otherwise the
+ * test of its next sibling follows, and when no sibling is left the parent is
+ * returned (noTrueChildStrategy returnLastPrediction). Every node is thus the
+ * exit of exactly one path, and numbering the nodes in post-order makes the
+ * exits of a subtree contiguous. Every false test excludes the exits of the
+ * node's subtree, and the exit of the tree is the first one not excluded.
+ *
+ * The tests of all trees are grouped by feature and sorted by threshold, so
+ * that for each feature of a sample the false tests are a prefix of the list:
+ * they are found with a single scan, without visiting the trees.
+ *
+ * Trees which cannot be represented this way (more than 64 nodes, predicates
+ * other than comparisons and intervals, nodes without score, backtracking
+ * strategy) are scored through their own traversal. Samples with a missing
+ * value for any of the features tested are scored entirely through traversal,
+ * since the outcome then depends on which nodes are actually visited and on
+ * the missingValueStrategy of the trees, and so are the ones for which a
+ * segment scored through traversal gives no prediction.
+ */
+class QuickScorer {
+ public:
+  enum : uint32_t { none = std::numeric_limits<uint32_t>::max() };  // segment not handled by QuickScorer
+  enum : size_t { STACK_TREES = 512 };  // above this number of trees, the masks of a sample are stored in the heap
+
+  // Tests on a feature, each one excluding mask from the exits of tree when it fails
+  struct Tests {
+    std::vector<double> thresholds;
+    std::vector<uint32_t> trees;
+    std::vector<uint64_t> masks;
+  };
+
+  std::vector<uint32_t> features;
+  std::vector<Tests> upper_tests;  // node test false when value > threshold, sorted by increasing threshold
+  std::vector<Tests> lower_tests;  // node test false when value < threshold, sorted by decreasing threshold
+  std::vector<uint32_t> segment_trees;  // tree index of each segment, none if scored through traversal
+  std::vector<uint64_t> initial_masks;
+  std::vector<uint32_t> leaf_offsets;  // index in leaf_values of the first exit of each tree
+  std::vector<double> leaf_values;
+
+  QuickScorer() = default;
+
+  explicit QuickScorer(const std::vector<Segment> &ensemble) {
+    std::vector<Test> tests;
+    for (const auto &segment : ensemble) {
+      const TreeModel *model = dynamic_cast<const TreeModel *>(segment.model.get());
+      segment_trees.push_back(model && is_true(segment.predicate) ? add_tree(model->tree, tests) : none);
+    }
+
+    build_tests(tests);
+  }
+
+  inline bool empty() const { return initial_masks.empty(); }
+
+  /**
+   * Sum of the predictions of the segments of ensemble, the one built from.
+   * It returns false when the sample has to be scored through traversal.
+   */
+  inline bool sum(const Sample &sample, const std::vector<Segment> &ensemble, double &result) const {
+    if (initial_masks.size() <= STACK_TREES) {
+      uint64_t masks[STACK_TREES];
+      return sum(sample, ensemble, masks, result);
+    }
+
+    std::vector<uint64_t> masks(initial_masks.size());
+    return sum(sample, ensemble, masks.data(), result);
+  }
+
+ private:
+  struct Test {
+    uint32_t feature;
+    bool upper;
+    double threshold;
+    uint32_t tree;
+    uint64_t mask;
+  };
+
+  // As the public one, computing the exits of the trees into masks
+  inline bool sum(const Sample &sample, const std::vector<Segment> &ensemble, uint64_t *masks, double &result) const {
+    std::copy(initial_masks.cbegin(), initial_masks.cend(), masks);
+
+    for (auto i = 0u; i < features.size(); i++) {
+      const Value &value = sample[features[i]].value;
+      if (value.missing) return false;
+
+      apply_upper(upper_tests[i], value.value, masks);
+      apply_lower(lower_tests[i], value.value, masks);
+    }
+
+    result = 0;
+    for (auto i = 0u; i < ensemble.size(); i++) {
+      const uint32_t tree = segment_trees[i];
+      if (tree == none) {
+        if (!ensemble[i].predicate(sample)) continue;
+
+        const double prediction = ensemble[i].predict_double(sample);
+        if (prediction == double_min()) return false;  // no prediction, handled by traversal
+        result += prediction;
+      } else {
+        result += leaf_values[leaf_offsets[tree] + __builtin_ctzll(masks[tree])];
+      }
+    }
+
+    return true;
+  }
+
+  inline static void apply_upper(const Tests &tests, const double value, uint64_t *masks) {
+    for (auto i = 0u; i < tests.thresholds.size() && value > tests.thresholds[i]; i++)
+      masks[tests.trees[i]] &= tests.masks[i];
+  }
+
+  inline static void apply_lower(const Tests &tests, const double value, uint64_t *masks) {
+    for (auto i = 0u; i < tests.thresholds.size() && value < tests.thresholds[i]; i++)
+      masks[tests.trees[i]] &= tests.masks[i];
+  }
+
+  inline static bool is_true(const PredicateProgram &predicate) {
+    return predicate.empty() || predicate.instructions[0].opcode == PredicateProgram::OpCode::TRUE;
+  }
+
+  // Index of the tree added, none if tree cannot be scored by QuickScorer
+  inline uint32_t add_tree(const FlatTree &tree, std::vector<Test> &tests) {
+    if (tree.size() > 64 || (!tree.leaves[0] && !tree.return_last_prediction)) return none;
+    for (auto node = 0u; node < tree.size(); node++)
+      if (!tree.is_score[node] || !tree.has_simple_score[node]) return none;
+
+    std::vector<uint32_t> first(tree.size());
+    std::vector<uint32_t> exits(tree.size());
+    uint32_t counter = 0;
+    number(tree, 0, counter, first, exits);
+
+    const uint32_t index = initial_masks.size();
+    std::vector<Test> tree_tests;
+    for (auto node = 1u; node < tree.size(); node++) {
+      // exits of the subtree of node, excluded when its test fails
+      const uint64_t subtree = (exits[node] == 63 ? ~uint64_t(0) : (uint64_t(1) << (exits[node] + 1)) - 1) &
+                               ~((uint64_t(1) << first[node]) - 1);
+      if (!add_tests(tree.predicates, tree.predicate_starts[node], index, ~subtree, tree_tests)) return none;
+    }
+
+    tests.insert(tests.end(), tree_tests.begin(), tree_tests.end());
+    initial_masks.push_back(tree.size() == 64 ? ~uint64_t(0) : (uint64_t(1) << tree.size()) - 1);
+    leaf_offsets.push_back(leaf_values.size());
+    leaf_values.resize(leaf_values.size() + tree.size());
+    for (auto node = 0u; node < tree.size(); node++)
+      leaf_values[leaf_offsets.back() + exits[node]] = tree.double_score(node);
+
+    return index;
+  }
+
+  // Post-order numbering of the nodes, along with the first number in the subtree of each node
+  inline static void number(const FlatTree &tree, const uint32_t node, uint32_t &counter, std::vector<uint32_t> &first,
+                            std::vector<uint32_t> &exits) {
+    first[node] = counter;
+    if (!tree.leaves[node])
+      for (uint32_t child = node + 1; child != FlatTree::none; child = tree.next_siblings[child])
+        number(tree, child, counter, first, exits);
+    exits[node] = counter++;
+  }
+
+  // Tests equivalent to the predicate starting at start, false if there are none
+  inline static bool add_tests(const PredicateProgram &program, const uint32_t start, const uint32_t tree,
+                               const uint64_t mask, std::vector<Test> &tests) {
+    const PredicateProgram::Instruction &instruction = program.instructions[start];
+    const double lowest = -std::numeric_limits<double>::infinity();
+    const double highest = std::numeric_limits<double>::infinity();
+    switch (instruction.opcode) {
+      case PredicateProgram::OpCode::TRUE:
+        return true;
+      case PredicateProgram::OpCode::LESS_OR_EQUAL:
+        tests.push_back(Test{instruction.feature, true, instruction.threshold, tree, mask});
+        return true;
+      case PredicateProgram::OpCode::LESS_THAN:
+        tests.push_back(Test{instruction.feature, true, std::nextafter(instruction.threshold, lowest), tree, mask});
+        return true;
+      case PredicateProgram::OpCode::GREATER_OR_EQUAL:
+        tests.push_back(Test{instruction.feature, false, instruction.threshold, tree, mask});
+        return true;
+      case PredicateProgram::OpCode::GREATER_THAN:
+        tests.push_back(Test{instruction.feature, false, std::nextafter(instruction.threshold, highest), tree, mask});
+        return true;
+      case PredicateProgram::OpCode::EQUAL:
+        tests.push_back(Test{instruction.feature, true, instruction.threshold, tree, mask});
+        tests.push_back(Test{instruction.feature, false, instruction.threshold, tree, mask});
+        return true;
+      case PredicateProgram::OpCode::RANGE_CLOSED_CLOSED:
+        tests.push_back(Test{instruction.feature, true, instruction.high, tree, mask});
+        tests.push_back(Test{instruction.feature, false, instruction.low, tree, mask});
+        return true;
+      case PredicateProgram::OpCode::RANGE_OPEN_OPEN:
+        tests.push_back(Test{instruction.feature, true, std::nextafter(instruction.high, lowest), tree, mask});
+        tests.push_back(Test{instruction.feature, false, std::nextafter(instruction.low, highest), tree, mask});
+        return true;
+      case PredicateProgram::OpCode::RANGE_CLOSED_OPEN:
+        tests.push_back(Test{instruction.feature, true, std::nextafter(instruction.high, lowest), tree, mask});
+        tests.push_back(Test{instruction.feature, false, instruction.low, tree, mask});
+        return true;
+      case PredicateProgram::OpCode::RANGE_OPEN_CLOSED:
+        tests.push_back(Test{instruction.feature, true, instruction.high, tree, mask});
+        tests.push_back(Test{instruction.feature, false, std::nextafter(instruction.low, highest), tree, mask});
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  inline void build_tests(std::vector<Test> &tests) {
+    std::stable_sort(tests.begin(), tests.end(), [](const Test &a, const Test &b) {
+      if (a.feature != b.feature) return a.feature < b.feature;
+      if (a.upper != b.upper) return a.upper;
+      return a.upper ? a.threshold < b.threshold : a.threshold > b.threshold;
+    });
+
+    for (const auto &test : tests) {
+      if (features.empty() || features.back() != test.feature) {
+        features.push_back(test.feature);
+        upper_tests.push_back(Tests());
+        lower_tests.push_back(Tests());
+      }
+
+      Tests &feature_tests = test.upper ? upper_tests.back() : lower_tests.back();
+      feature_tests.thresholds.push_back(test.threshold);
+      feature_tests.trees.push_back(test.tree);
+      feature_tests.masks.push_back(test.mask);
+    }
+  }
+};
+
+#endif
@@ -11,6 +11,7 @@
 
 #include "core/internal_model.h"
 #include "core/predicatebuilder.h"
+#include "core/predicateprogram.h"
 #include "ensemblemodel.h"
 
 /**
@@ -27,20 +28,45 @@ class Segment {
  public:
   std::string id;
   double weight = 1;
-  Predicate predicate;
+  PredicateProgram predicate;
   std::shared_ptr<InternalModel> model;
+  std::vector<int> class_map;        // class id in the ensemble of each class id of the model
+  std::vector<uint32_t> label_map;  // label id in the ensemble of each label id of the model
 
   Segment() = default;
 
   Segment(const XmlNode &node, const PredicateBuilder &predicate_builder, const std::shared_ptr<InternalModel> &model)
       : id(node.get_attribute("id")),
         weight(node.get_double_attribute("weight")),
-        predicate(predicate_builder.build(node.get_child_bypattern("Predicate"))),
+        predicate(PredicateProgram(predicate_builder.build(node.get_child_bypattern("Predicate")))),
         model(model) {}
 
   inline std::unique_ptr<InternalScore> score(const Sample &sample) const { return model->score_raw(sample); }
 
+  // Moves the probabilities of a score of the model to the labels of the ensemble
+  inline void relabel(InternalScore &score, const std::shared_ptr<const LabelTable> &labels) const {
+    std::vector<double> probabilities(labels->size(), double_min());
+    for (auto i = 0u; i < score.probabilities.size(); i++)
+      if (score.has_probability(i)) probabilities[label_map[i]] = score.probabilities[i];
+
+    score.labels = labels;
+    score.probabilities.swap(probabilities);
+  }
+
   inline std::string predict(const Sample &sample) const { return model->predict_raw(sample); }
+
+  inline double predict_double(const Sample &sample) const {
+    double predicted;
+
+    return model->predict_double_raw(sample, predicted) ? predicted : double_min();
+  }
+
+  // Class id in the ensemble of the predicted class, no_class when the model doesn't predict any
+  inline size_t predict_class(const Sample &sample, const size_t no_class) const {
+    const int class_id = model->predict_class_raw(sample);
+
+    return class_id < 0 ? no_class : class_map[class_id];
+  }
 };
 
 #endif
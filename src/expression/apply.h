@@ -37,6 +37,9 @@ class Apply : public Expression {
   Value defaultValue;
   InvalidValueTreatmentMethod invalidValueTreatmentMethod;
   std::vector<std::shared_ptr<Expression>> expressions;
+  std::shared_ptr<const StringDictionary> dictionary;  // the one of the model, to encode strings built during scoring
+
+  enum : size_t { STACK_ARGUMENTS = 16 };  // above this number of arguments, they are evaluated into the heap
 
   Apply() = default;
 
@@ -48,7 +51,8 @@ class Apply : public Expression {
         mapmissing_to(exist_missingreplacement ? Value(node.get_attribute("mapMissingTo"), output_type) : Value()),
         exist_defaultvalue(node.exists_attribute("defaultValue")),
         defaultValue(exist_defaultvalue ? Value(node.get_attribute("defaultValue"), output_type) : Value()),
-        invalidValueTreatmentMethod(node.get_attribute("invalidValueTreatment")) {
+        invalidValueTreatmentMethod(node.get_attribute("invalidValueTreatment")),
+        dictionary(StringDictionary::Loading::current()) {
     std::shared_ptr<Expression> expression;
     for (const auto &n : node.get_childs()) {
       ExpressionType expression_type(n.name());
@@ -85,49 +89,61 @@ class Apply : public Expression {
   }
 
   inline Value eval(Sample &sample) const override {
-    std::vector<Value> input;
-    Value tmp;
-    bool missing_input = false;
-    for (const auto &expression : expressions) {
-      tmp = expression->eval(sample);
-      input.push_back(tmp);
-      if (tmp.missing) missing_input = true;
+    if (expressions.size() <= STACK_ARGUMENTS) {
+      Value input[STACK_ARGUMENTS];
+      return eval(sample, input);
     }
 
-    if (missing_input) {
-      if (exist_missingreplacement)
-        return mapmissing_to;
-      else if (exist_defaultvalue)
-        return defaultValue;
-      else
-        return Value();
+    std::vector<Value> input(expressions.size());
+    return eval(sample, input.data());
+  }
+
+ private:
+  // Evaluates the arguments into input, then the function on them
+  inline Value eval(Sample &sample, Value *input) const {
+    bool missing_input = false;
+    for (auto i = 0u; i < expressions.size(); i++) {
+      input[i] = expressions[i]->eval(sample);
+      if (input[i].missing) missing_input = true;
     }
 
+    if (missing_input) return missing_result();
+
     Value result;
 
     try {  // there is no rule in PMML for validation at this level, here
            // invalid is like "division by zero"
       // thus it is captured with an exception
-      result = function(input);
-    } catch (const std::exception &e) {
-      std::cout << e.what() << std::endl;
+      result = function(input, expressions.size());
+      if (result.missing) return missing_result();  // unknown, as the comparison of two strings unseen by the model
+    } catch (const std::exception &) {
       switch (invalidValueTreatmentMethod.value) {
         case InvalidValueTreatmentMethod::InvalidValueTreatmentMethodValue::RETURN_INVALID:
           throw cpmml::InvalidValueException("evaluating apply function");
         case InvalidValueTreatmentMethod::InvalidValueTreatmentMethodValue::AS_MISSING:
-          if (exist_missingreplacement)
-            return mapmissing_to;
-          else if (exist_defaultvalue)
-            return defaultValue;
-          else
-            return Value();
+          return missing_result();
         case InvalidValueTreatmentMethod::InvalidValueTreatmentMethodValue::AS_IS:
           break;
       }
     }
 
+#ifdef REGEX_SUPPORT
+    // the string built is encoded through the dictionary of the model, so that it can match the strings of the model
+    if (function.function_type == BuiltInFunction::BuiltInFunctionType::REPLACE && !result.missing && dictionary)
+      result = Value::encoded(result.svalue, *dictionary);
+#endif
+
     return result;
   }
+
+  inline Value missing_result() const {
+    if (exist_missingreplacement)
+      return mapmissing_to;
+    else if (exist_defaultvalue)
+      return defaultValue;
+    else
+      return Value();
+  }
 };
 
 #endif
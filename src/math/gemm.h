@@ -0,0 +1,102 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_GEMM_H
+#define CPMML_GEMM_H
+
+#include <algorithm>
+#include <cstddef>
+
+#ifdef BLAS_SUPPORT
+#include <cblas.h>
+#endif
+
+/**
+ * @defgroup Gemm
+ *
+ * Matrix multiplication C = A * B^T, where A is a row-major m x k matrix, B is
+ * a row-major n x k matrix and C is a row-major m x n matrix.
+ *
+ * This is the shape of the product between a block of samples (one per row of
+ * A) and a set of coefficient vectors (one per row of B), such as the tables
+ * of a RegressionMatrix.
+ *
+ * When BLAS_SUPPORT is defined the product is delegated to cblas_dgemm,
+ * otherwise it is computed with a cache-blocked loop: the k dimension is split
+ * into panels fitting in cache, and inside each panel a micro-kernel computes
+ * tiles of up to GEMM_TILE x GEMM_TILE dot products at once, so that every
+ * element loaded is used up to GEMM_TILE times. The loops of the micro-kernel run over
+ * contiguous memory and are vectorized by the compiler.
+ */
+//@{
+#define GEMM_TILE 4
+#define GEMM_PANEL 256
+
+// Tile of rows x columns elements of C, starting at c, accumulated over the panel of depth elements
+template <size_t rows, size_t columns>
+inline void gemm_nt_tile(const double *a, const double *b, double *c, const size_t lda, const size_t ldb,
+                         const size_t ldc, const size_t depth) {
+  double accumulators[rows][columns] = {};
+  for (auto p = 0u; p < depth; p++)
+    for (auto i = 0u; i < rows; i++)
+      for (auto j = 0u; j < columns; j++) accumulators[i][j] += a[i * lda + p] * b[j * ldb + p];
+
+  for (auto i = 0u; i < rows; i++)
+    for (auto j = 0u; j < columns; j++) c[i * ldc + j] += accumulators[i][j];
+}
+
+// Tile at the bottom border of C, with less than GEMM_TILE rows
+inline void gemm_nt_border(const double *a, const double *b, double *c, const size_t lda, const size_t ldb,
+                           const size_t ldc, const size_t rows, const size_t columns, const size_t depth) {
+  for (auto i = 0u; i < rows; i++)
+    for (auto j = 0u; j < columns; j++) {
+      double accumulator = 0;
+      for (auto p = 0u; p < depth; p++) accumulator += a[i * lda + p] * b[j * ldb + p];
+      c[i * ldc + j] += accumulator;
+    }
+}
+
+inline void gemm_nt(const double *a, const double *b, double *c, const size_t m, const size_t n, const size_t k) {
+  std::fill(c, c + m * n, 0.0);
+  if (m == 0 || n == 0 || k == 0) return;
+
+#ifdef BLAS_SUPPORT
+  cblas_dgemm(CblasRowMajor, CblasNoTrans, CblasTrans, m, n, k, 1.0, a, k, b, k, 0.0, c, n);
+#else
+  for (size_t p = 0; p < k; p += GEMM_PANEL) {
+    const size_t depth = std::min<size_t>(GEMM_PANEL, k - p);
+    for (size_t i = 0; i < m; i += GEMM_TILE) {
+      const size_t rows = std::min<size_t>(GEMM_TILE, m - i);
+      for (size_t j = 0; j < n; j += GEMM_TILE) {
+        const size_t columns = std::min<size_t>(GEMM_TILE, n - j);
+        const double *a_tile = a + i * k + p;
+        const double *b_tile = b + j * k + p;
+        double *c_tile = c + i * n + j;
+        if (rows < GEMM_TILE) {
+          gemm_nt_border(a_tile, b_tile, c_tile, k, k, n, rows, columns, depth);
+          continue;
+        }
+
+        switch (columns) {
+          case 1:
+            gemm_nt_tile<GEMM_TILE, 1>(a_tile, b_tile, c_tile, k, k, n, depth);
+            break;
+          case 2:
+            gemm_nt_tile<GEMM_TILE, 2>(a_tile, b_tile, c_tile, k, k, n, depth);
+            break;
+          case 3:
+            gemm_nt_tile<GEMM_TILE, 3>(a_tile, b_tile, c_tile, k, k, n, depth);
+            break;
+          default:
+            gemm_nt_tile<GEMM_TILE, GEMM_TILE>(a_tile, b_tile, c_tile, k, k, n, depth);
+        }
+      }
+    }
+  }
+#endif
+}
+//@}
+#endif
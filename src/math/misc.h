@@ -11,7 +11,6 @@
 #include <functional>
 #include <vector>
 
-#include "boost/integral.h"
 #include "utils/utils.h"
 
 /**
@@ -26,22 +25,25 @@ inline double closest0or1(const double &value) {
   return value;
 }
 
-inline double probit(const double a) {
-  std::function<double(double)> function = [](double a) {
-    return (1 / std::sqrt(2 * M_PI)) * std::exp(-0.5 * std::pow(a, 2));
-  };
-  return ::integral(::double_min(), a, 0.01, function);
-}
+// Standard normal CDF, in closed form through the complementary error function
+inline double probit(const double a) { return 0.5 * std::erfc(-a * M_SQRT1_2); }
+
+// exp is only evaluated on non positive arguments, so that it never overflows
+inline double logit(const double a) {
+  if (a >= 0) return 1 / (1 + std::exp(-a));
 
-inline double logit(const double a) { return 1 / (1 + std::exp(-a)); }
+  const double e = std::exp(a);
+  return e / (1 + e);
+}
 
 inline double _exp(const double a) { return std::exp(a); }
 
-inline double cloglog(const double a) { return 1 - std::exp(-std::exp(a)); }
+inline double cloglog(const double a) { return -std::expm1(-std::exp(a)); }
 
-inline double loglog(const double a) { return std::exp(-std::exp(a)); }
+inline double loglog(const double a) { return std::exp(-std::exp(-a)); }
 
-inline double cauchit(const double a) { return 0.5 + (1 / M_PI) * atan(a); }
+// atan(1 / a) avoids the cancellation of 0.5 + atan(a) / pi for large negative values
+inline double cauchit(const double a) { return a < 0 ? -std::atan(1 / a) / M_PI : 0.5 + std::atan(a) / M_PI; }
 
 inline double _round(const double a) { return std::round(a); }
 
@@ -50,5 +52,31 @@ inline double _floor(const double a) { return std::floor(a); }
 inline double _ceil(const double a) { return std::ceil(a); }
 
 inline double _identity(const double a) { return a; }
+
+// Batch versions, applying the function to the n elements of values and storing the results in result (which can be
+// values itself)
+inline void probit(const double *values, double *result, const size_t n) {
+  for (auto i = 0u; i < n; i++) result[i] = probit(values[i]);
+}
+
+inline void logit(const double *values, double *result, const size_t n) {
+  for (auto i = 0u; i < n; i++) result[i] = logit(values[i]);
+}
+
+inline void _exp(const double *values, double *result, const size_t n) {
+  for (auto i = 0u; i < n; i++) result[i] = std::exp(values[i]);
+}
+
+inline void cloglog(const double *values, double *result, const size_t n) {
+  for (auto i = 0u; i < n; i++) result[i] = cloglog(values[i]);
+}
+
+inline void loglog(const double *values, double *result, const size_t n) {
+  for (auto i = 0u; i < n; i++) result[i] = loglog(values[i]);
+}
+
+inline void cauchit(const double *values, double *result, const size_t n) {
+  for (auto i = 0u; i < n; i++) result[i] = cauchit(values[i]);
+}
 //@}
 #endif
@@ -7,8 +7,9 @@
 #ifndef CPMML_NORMALIZATIONMETHODS_H
 #define CPMML_NORMALIZATIONMETHODS_H
 
+#include <algorithm>
 #include <cmath>
-#include <functional>
+#include <string>
 #include <vector>
 
 #include "misc.h"
@@ -21,89 +22,78 @@
  * Normalization Methods</a>.
  */
 //@{
-inline std::vector<double> categorical_softmax(const std::vector<double> &values) {
-  std::vector<double> exps;
-  std::vector<double> result;
-  double sum = 0;
-  for (auto i = 0u; i < values.size(); i++) {
-    exps.push_back(std::exp(values[i]));
-    sum += exps.back();
-  }
+// Normalization of the scores of the classes, performed in place over the n_values elements of values
+typedef void (*CategoricalNormalization)(double *values, const size_t n_values);
 
-  for (auto i = 0u; i < values.size(); i++) result.push_back(exps[i] / sum);
+// The maximum is subtracted before exponentiation, so that exp never overflows; each step is a separate loop over the
+// classes, which the compiler can vectorize
+inline void categorical_softmax(double *values, const size_t n_values) {
+  double max = values[0];
+  for (auto i = 1u; i < n_values; i++) max = std::max(max, values[i]);
 
-  return result;
-}
+  for (auto i = 0u; i < n_values; i++) values[i] = std::exp(values[i] - max);
 
-inline std::vector<double> categorical_simplemax(const std::vector<double> &values) {
-  std::vector<double> result;
   double sum = 0;
+  for (auto i = 0u; i < n_values; i++) sum += values[i];
 
-  for (const auto &value : values) sum += value;
+  const double inverse = 1 / sum;
+  for (auto i = 0u; i < n_values; i++) values[i] *= inverse;
+}
 
-  for (const auto &value : values) result.push_back(value / sum);
+inline void categorical_simplemax(double *values, const size_t n_values) {
+  double sum = 0;
+  for (auto i = 0u; i < n_values; i++) sum += values[i];
 
-  return result;
+  for (auto i = 0u; i < n_values; i++) values[i] /= sum;
 }
 
-inline std::vector<double> categorical_none(const std::vector<double> &values) {
-  std::vector<double> result;
+inline void categorical_none(double *values, const size_t n_values) {
   double sum = 0;
-  size_t i = 0;
-
-  for (i = 0; i < values.size() - 1; i++) {
-    sum += values[i];
-    result.push_back(values[i]);
-  }
+  for (auto i = 0u; i + 1 < n_values; i++) sum += values[i];
 
-  result.push_back(1 - sum);
+  values[n_values - 1] = 1 - sum;
 
-  if (values.size() == 2) {
-    result[0] = closest0or1(result[0]);
-    result[1] = closest0or1(result[1]);
+  if (n_values == 2) {
+    values[0] = closest0or1(values[0]);
+    values[1] = closest0or1(values[1]);
   }
-
-  return result;
 }
 
-inline std::vector<double> categorical_base(const std::vector<double> &values, std::function<double(double)> function,
-                                            const std::string &function_name) {
-  if (values.size() != 2) throw cpmml::MathException(function_name + " must have exactly 2 inputs");
-
-  std::vector<double> result;
-  result.push_back(function(values[0]));
-  result.push_back(1 - result[0]);
+inline void categorical_base(double *values, const size_t n_values, double (*function)(double),
+                             const std::string &function_name) {
+  if (n_values != 2) throw cpmml::MathException(function_name + " must have exactly 2 inputs");
 
-  return result;
+  values[0] = function(values[0]);
+  values[1] = 1 - values[0];
 }
 
-inline std::vector<double> categorical_logit(const std::vector<double> &values) {
-  return categorical_base(values, logit, "logit");
+inline void categorical_logit(double *values, const size_t n_values) {
+  categorical_base(values, n_values, logit, "logit");
 }
 
-inline std::vector<double> categorical_probit(const std::vector<double> &values) {
-  return categorical_base(values, probit, "probit");
+inline void categorical_probit(double *values, const size_t n_values) {
+  categorical_base(values, n_values, probit, "probit");
 }
 
-inline std::vector<double> categorical_cloglog(const std::vector<double> &values) {
-  return categorical_base(values, cloglog, "cloglog");
+inline void categorical_cloglog(double *values, const size_t n_values) {
+  categorical_base(values, n_values, cloglog, "cloglog");
 }
 
-inline std::vector<double> categorical_loglog(const std::vector<double> &values) {
-  return categorical_base(values, loglog, "loglog");
+inline void categorical_loglog(double *values, const size_t n_values) {
+  categorical_base(values, n_values, loglog, "loglog");
 }
 
-inline std::vector<double> categorical_cauchit(const std::vector<double> &values) {
-  if (values.size() != 2) throw cpmml::MathException("Cauchit must have exactly 2 inputs");
-
-  std::vector<double> result;
-  result.push_back(cauchit(values[0]));
-  result.push_back(1 - result[0]);
+inline void categorical_cauchit(double *values, const size_t n_values) {
+  categorical_base(values, n_values, cauchit, "Cauchit");
+}
 
-  return result;
+// Batch version, normalizing the rows of the n_samples x n_values row-major matrix values
+inline void categorical_batch(CategoricalNormalization normalization, double *values, const size_t n_samples,
+                              const size_t n_values) {
+  for (auto i = 0u; i < n_samples; i++) normalization(values + i * n_values, n_values);
 }
 
-inline std::vector<double> ordinal_base(const std::vector<double> &values, std::function<double(double)> function) {
+inline std::vector<double> ordinal_base(const std::vector<double> &values, double (*function)(double)) {
   std::vector<double> result;
 
   result.push_back(function(values[0]));
@@ -125,9 +115,10 @@ inline std::vector<double> ordinal_loglog(const std::vector<double> &values) { r
 
 inline std::vector<double> ordinal_cauchit(const std::vector<double> &values) { return ordinal_base(values, cauchit); }
 
-inline std::vector<double> ordinal_none(const std::vector<double> &values) {
-  return ordinal_base(values, [](double a) { return a; });
-}
+inline std::vector<double> ordinal_none(const std::vector<double> &values) { return ordinal_base(values, _identity); }
+
+// Normalization of the score of a continuous variable
+typedef double (*SingleNormalization)(const double &value);
 
 inline double single_logit(const double &a) { return logit(a); }
 
@@ -144,5 +135,26 @@ inline double single_loglog(const double &a) { return loglog(a); }
 inline double single_cauchit(const double &a) { return cauchit(a); }
 
 inline double single_none(const double &a) { return a; }
+
+// Batch version, normalizing the n scores of values into result (which can be values itself)
+typedef void (*SingleBatchNormalization)(const double *values, double *result, const size_t n);
+
+inline void single_batch_logit(const double *values, double *result, const size_t n) { logit(values, result, n); }
+
+inline void single_batch_softmax(const double *values, double *result, const size_t n) { logit(values, result, n); }
+
+inline void single_batch_exp(const double *values, double *result, const size_t n) { _exp(values, result, n); }
+
+inline void single_batch_probit(const double *values, double *result, const size_t n) { probit(values, result, n); }
+
+inline void single_batch_cloglog(const double *values, double *result, const size_t n) { cloglog(values, result, n); }
+
+inline void single_batch_loglog(const double *values, double *result, const size_t n) { loglog(values, result, n); }
+
+inline void single_batch_cauchit(const double *values, double *result, const size_t n) { cauchit(values, result, n); }
+
+inline void single_batch_none(const double *values, double *result, const size_t n) {
+  if (values != result) std::copy(values, values + n, result);
+}
 //@}
 #endif
@@ -7,7 +7,7 @@
 #ifndef CPMML_OPTIONS_H
 #define CPMML_OPTIONS_H
 
-#define STRING_OPTIMIZATION
+#define QUICKSCORER
 //#define DEBUG
 
 #endif
@@ -29,13 +29,23 @@ class OutputDictionary {
   bool empty;
   std::unordered_map<std::string, OutputField> raw_outputfields;
   std::vector<OutputField> dag;
+  std::shared_ptr<LabelTable> num_output_names;  // names of the numeric outputs, by id
+  std::shared_ptr<LabelTable> str_output_names;  // names of the string outputs, by id
 
   OutputDictionary() : empty(true) {}
 
-  OutputDictionary(const XmlNode &node, const std::shared_ptr<Indexer> &indexer, const std::string &model_target)
+  OutputDictionary(const XmlNode &node, const std::shared_ptr<Indexer> &indexer, const std::string &model_target,
+                   LabelTable &labels)
       : empty(false),
-        raw_outputfields(OutputField::to_outputfields(node.get_childs("OutputField"), indexer, model_target)),
-        dag(build_dag(raw_outputfields)) {}
+        raw_outputfields(OutputField::to_outputfields(node.get_childs("OutputField"), indexer, model_target, labels)),
+        num_output_names(std::make_shared<LabelTable>()),
+        str_output_names(std::make_shared<LabelTable>()) {
+    for (auto &outputfield : raw_outputfields)
+      outputfield.second.id = outputfield.second.datatype == DataType::DataTypeValue::STRING
+                                  ? str_output_names->add(outputfield.first)
+                                  : num_output_names->add(outputfield.first);
+    dag = build_dag(raw_outputfields);
+  }
 
   inline bool contains(const std::string &field_name) const {
     return raw_outputfields.find(field_name) != raw_outputfields.cend();
@@ -74,9 +84,41 @@ class OutputDictionary {
     for (const auto &outputfield : dag) outputfield.prepare(sample);
   }
 
+  // Adds the output names of inner, so that the outputs it adds to a score are kept when this dictionary adds its own
+  // to the same score (see modelChain in MultipleModelMethod)
+  inline void include(const OutputDictionary &inner) {
+    if (empty || inner.empty) return;
+
+    for (const auto &name : inner.num_output_names->labels) num_output_names->add(name);
+    for (const auto &name : inner.str_output_names->labels) str_output_names->add(name);
+  }
+
   inline void add_output(Sample &sample, InternalScore &score) const {
+    if (empty) return;
+
+    if (score.num_output_names != num_output_names) {
+      rebase(score.num_output_names, *num_output_names, score.num_outputs);
+      score.num_output_names = num_output_names;
+    }
+    if (score.str_output_names != str_output_names) {
+      rebase(score.str_output_names, *str_output_names, score.str_outputs);
+      score.str_output_names = str_output_names;
+    }
     for (const auto &outputfield : dag) outputfield.add_output(sample, score);
   }
+
+  // Moves outputs, indexed by the ids of names, to the ids of the same names in to. Outputs missing in to are dropped.
+  template <class T>
+  static void rebase(const std::shared_ptr<const LabelTable> &names, const LabelTable &to, std::vector<T> &outputs) {
+    std::vector<T> rebased(to.size());
+    if (names)
+      for (auto i = 0u; i < names->size() && i < outputs.size(); i++) {
+        const uint32_t id = to.find((*names)[i]);
+        if (id != LabelTable::none) rebased[id] = std::move(outputs[i]);
+      }
+
+    outputs.swap(rebased);
+  }
 };
 
 #endif
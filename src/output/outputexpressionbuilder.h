@@ -28,7 +28,7 @@ class OutputExpressionBuilder {
   inline static std::shared_ptr<OutputExpression> build(const XmlNode &node, const unsigned int &output_index,
                                                         const DataType &output_type,
                                                         const std::shared_ptr<Indexer> &indexer,
-                                                        const std::string &model_target) {
+                                                        const std::string &model_target, LabelTable &labels) {
     switch (OutputExpressionType(node.get_attribute("feature")).value) {
       case OutputExpressionType::OutputExpressionTypeValue::PREDICTED_VALUE:
         return std::make_shared<PredictedValue>(model_target, indexer, output_index, output_type);
@@ -37,7 +37,7 @@ class OutputExpressionBuilder {
       case OutputExpressionType::OutputExpressionTypeValue::TRANSFORMED_VALUE:
         return std::make_shared<TransformedValue>(node, indexer, output_index, output_type);
       case OutputExpressionType::OutputExpressionTypeValue::PROBABILITY:
-        return std::make_shared<Probability>(node, indexer, output_index, output_type);
+        return std::make_shared<Probability>(node, indexer, output_index, output_type, labels);
       case OutputExpressionType::OutputExpressionTypeValue::PASS_VALUE:
         return std::make_shared<PredictedValue>(model_target, indexer, output_index, output_type);
       default:
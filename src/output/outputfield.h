@@ -30,11 +30,13 @@ class OutputField {
   bool derived;
   DataType datatype;
   size_t index;
+  uint32_t id = LabelTable::none;  // index in the outputs of InternalScore of the same type
   std::shared_ptr<OutputExpression> expression;
 
   OutputField() : derived(false), index(std::numeric_limits<size_t>::max()) {}
 
-  OutputField(const XmlNode &node, const std::shared_ptr<Indexer> &indexer, const std::string &model_target)
+  OutputField(const XmlNode &node, const std::shared_ptr<Indexer> &indexer, const std::string &model_target,
+              LabelTable &labels)
       : name(node.get_attribute("name")),
         optype(node.get_attribute("optype")),
         derived(OutputExpressionType(node.get_attribute("feature")).value ==
@@ -50,7 +52,7 @@ class OutputField {
       datatype = node.get_attribute("dataType");
 
     index = indexer->get_or_set(name, datatype).first;
-    expression = OutputExpressionBuilder::build(node, index, datatype, indexer, model_target);
+    expression = OutputExpressionBuilder::build(node, index, datatype, indexer, model_target, labels);
   }
 
   inline void prepare(Sample &sample) const { sample.change_value_if_missing(index, expression->eval(sample)); }
@@ -58,19 +60,20 @@ class OutputField {
   inline void add_output(Sample &sample, InternalScore &score) const {
     switch (datatype.value) {
       case DataType::DataTypeValue::STRING:
-        score.str_outputs[name] = expression->eval_str(sample, score);
+        score.str_outputs[id] = expression->eval_str(sample, score);
         break;
       default:
-        score.num_outputs[name] = expression->eval_double(sample, score);
+        score.num_outputs[id] = expression->eval_double(sample, score);
     }
   }
 
   inline static std::unordered_map<std::string, OutputField> to_outputfields(const std::vector<XmlNode> &nodes,
                                                                              std::shared_ptr<Indexer> indexer,
-                                                                             const std::string &model_target) {
+                                                                             const std::string &model_target,
+                                                                             LabelTable &labels) {
     std::unordered_map<std::string, OutputField> result;
     for (const auto &node : nodes) {
-      OutputField derived_field(node, indexer, model_target);
+      OutputField derived_field(node, indexer, model_target, labels);
       result.insert(std::make_pair(derived_field.name, derived_field));
     }
 
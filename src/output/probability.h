@@ -25,16 +25,18 @@ class Probability : public OutputExpression {
  public:
   size_t index;
   std::string target_value;
+  uint32_t label = LabelTable::none;  // id of target_value among the labels of the model
 
   Probability() : index(std::numeric_limits<size_t>::max()) {}
 
   Probability(const XmlNode &node, const std::shared_ptr<Indexer> &indexer, const size_t &output_index,
-              const DataType &output_type)
-      : OutputExpression(output_index, output_type, indexer), target_value(node.get_attribute("value")) {}
+              const DataType &output_type, LabelTable &labels)
+      : OutputExpression(output_index, output_type, indexer),
+        target_value(node.get_attribute("value")),
+        label(labels.add(target_value)) {}
 
   inline virtual double eval_double(Sample &sample, const InternalScore &score) const override {
-    if (score.probabilities.find(target_value) != score.probabilities.cend())
-      return score.probabilities.at(target_value);
+    if (score.has_probability(label)) return score.probabilities[label];
 
     return double_min();
   };
@@ -7,6 +7,11 @@
 #ifndef CPMML_CATEGORICALPREDICTOR_H
 #define CPMML_CATEGORICALPREDICTOR_H
 
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "core/datatype.h"
 #include "core/sample.h"
 #include "core/value.h"
@@ -28,7 +33,7 @@ class CategoricalPredictor {
   std::string name;
   size_t index = std::numeric_limits<size_t>::max();
   DataType datatype;
-  std::unordered_map<Value, double, Value::ValueHash> coefficients;
+  std::vector<std::pair<double, double>> coefficients;  // level and its coefficient, scored by RegressionMatrix
 
   CategoricalPredictor() = default;
 
@@ -40,20 +45,21 @@ class CategoricalPredictor {
         coefficients(
             get_coefficients(node.get_childs_byattribute("CategoricalPredictor", "name", name), index, datatype)) {}
 
-  inline double get_term(const Sample &sample) const {
-    Value value = sample[index].value;
-
-    if (value.missing || coefficients.find(value) == coefficients.cend()) return 0;
-
-    return coefficients.at(value);
-  }
-
-  static std::unordered_map<Value, double, Value::ValueHash> get_coefficients(const std::vector<XmlNode> &nodes,
-                                                                              const size_t &index,
-                                                                              const DataType &datatype) {
-    std::unordered_map<Value, double, Value::ValueHash> result;
-    for (const auto &node : nodes)
-      result[Value(node.get_attribute("value"), datatype)] = ::to_double(node.get_attribute("coefficient"));
+  // A level given more than once keeps its last coefficient
+  static std::vector<std::pair<double, double>> get_coefficients(const std::vector<XmlNode> &nodes,
+                                                                 const size_t &index, const DataType &datatype) {
+    std::vector<std::pair<double, double>> result;
+    for (const auto &node : nodes) {
+      const double level = Value(node.get_attribute("value"), datatype).value;
+      const double coefficient = ::to_double(node.get_attribute("coefficient"));
+      auto same_level = std::find_if(result.begin(), result.end(), [level](const std::pair<double, double> &other) {
+        return other.first == level;
+      });
+      if (same_level == result.end())
+        result.push_back(std::make_pair(level, coefficient));
+      else
+        same_level->second = coefficient;
+    }
 
     return result;
   }
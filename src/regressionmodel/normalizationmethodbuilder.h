@@ -7,8 +7,6 @@
 #ifndef CPMML_NORMALIZATIONMETHODBUILDER_H
 #define CPMML_NORMALIZATIONMETHODBUILDER_H
 
-#include <functional>
-
 #include "math/normalizationmethods.h"
 #include "normalizationmethodtype.h"
 
@@ -20,7 +18,7 @@
  */
 class SingleNormalizationMethodBuilder {
  public:
-  static std::function<double(const double &)> build(const NormalizationMethodType &normalizationMethodType) {
+  static SingleNormalization build(const NormalizationMethodType &normalizationMethodType) {
     switch (normalizationMethodType.value) {
       case NormalizationMethodType::NormalizationMethodTypeValue::NONE:
         return single_none;
@@ -42,6 +40,30 @@ class SingleNormalizationMethodBuilder {
         throw cpmml::ParsingException("Incorrect normalization method");
     }
   }
+
+  // Batch version of build, normalizing the scores of several samples at once
+  static SingleBatchNormalization build_batch(const NormalizationMethodType &normalizationMethodType) {
+    switch (normalizationMethodType.value) {
+      case NormalizationMethodType::NormalizationMethodTypeValue::NONE:
+        return single_batch_none;
+      case NormalizationMethodType::NormalizationMethodTypeValue::SOFTMAX:
+        return single_batch_softmax;
+      case NormalizationMethodType::NormalizationMethodTypeValue::LOGIT:
+        return single_batch_logit;
+      case NormalizationMethodType::NormalizationMethodTypeValue::PROBIT:
+        return single_batch_probit;
+      case NormalizationMethodType::NormalizationMethodTypeValue::CLOGLOG:
+        return single_batch_cloglog;
+      case NormalizationMethodType::NormalizationMethodTypeValue::EXP:
+        return single_batch_exp;
+      case NormalizationMethodType::NormalizationMethodTypeValue::LOGLOG:
+        return single_batch_loglog;
+      case NormalizationMethodType::NormalizationMethodTypeValue::CAUCHIT:
+        return single_batch_cauchit;
+      default:
+        throw cpmml::ParsingException("Incorrect normalization method");
+    }
+  }
 };
 
 /**
@@ -49,11 +71,12 @@ class SingleNormalizationMethodBuilder {
  *
  * Factory class building the normalization method for a RegressionModel
  * predicting a categorical variable.
+ *
+ * The normalization is performed in place over the scores of the classes.
  */
 class MultiNormalizationMethodBuilder {
  public:
-  static std::function<std::vector<double>(const std::vector<double> &)> build(
-      const NormalizationMethodType &normalizationMethodType) {
+  static CategoricalNormalization build(const NormalizationMethodType &normalizationMethodType) {
     switch (normalizationMethodType.value) {
       case NormalizationMethodType::NormalizationMethodTypeValue::NONE:
         return categorical_none;
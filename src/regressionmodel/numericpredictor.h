@@ -45,11 +45,6 @@ class NumericPredictor {
         coefficient(node.get_double_attribute("coefficient")),
         exponent(node.exists_attribute("exponent") ? node.get_double_attribute("exponent") : 1) {}
 
-  inline double get_term(const Sample &sample) const {
-    const Value &value = sample[index].value;
-    return value.missing ? 0 : coefficient * std::pow(value.value, exponent);
-  }
-
   static std::vector<NumericPredictor> to_numericpredictors(const std::vector<XmlNode> &nodes,
                                                             const std::shared_ptr<Indexer> &indexer) {
     std::vector<NumericPredictor> result;
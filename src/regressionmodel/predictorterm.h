@@ -22,7 +22,8 @@
  * PredictorTerm</a>.
  *
  * It contains references to other fields in the PMML, which are combined by
- * multiplication.
+ * multiplication. A term with a missing factor is unknown, and so is the
+ * prediction of the RegressionModel (see missing).
  */
 class PredictorTerm {
   // this could be treated as a derived field visible in Statistics,
@@ -44,16 +45,18 @@ class PredictorTerm {
         coefficient(node.get_double_attribute("coefficient")),
         fields(SimpleFieldRef::to_simplefields(node.get_childs("FieldRef"), indexer)) {}
 
+  // Whether any factor of the term is missing for sample
+  inline bool missing(const Sample &sample) const {
+    for (const auto &field : fields)
+      if (field.value(sample).missing) return true;
+
+    return false;
+  }
+
+  // Term for sample, whose factors are not missing
   inline double get_term(const Sample &sample) const {
     double partial = 1;
-    for (const auto &field : fields) {
-      const Value &value = field.value(sample);
-      if (value.missing)
-        throw cpmml::MissingValueException("missing value index: " + std::to_string(field.index) +
-                                           " name: " + field.field_name);
-      else
-        partial *= value.value;
-    }
+    for (const auto &field : fields) partial *= field.value(sample).value;
 
     return coefficient * partial;
   }
@@ -30,7 +30,7 @@ class RegressionEvaluator : public InternalEvaluator {
 
   RegressionModel regression;
 
-  inline bool validate(const std::unordered_map<std::string, std::string> &sample) {
+  inline bool validate(const std::unordered_map<std::string, std::string> &sample) const override {
     return regression.validate(sample);
   }
 
@@ -44,6 +44,8 @@ class RegressionEvaluator : public InternalEvaluator {
   }
 
   inline std::string get_target_name() const override { return regression.target_field.name; };
+
+  inline const InternalModel &get_model() const override { return regression; }
 };
 
 #endif
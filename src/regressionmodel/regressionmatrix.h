@@ -0,0 +1,264 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_REGRESSIONMATRIX_H
+#define CPMML_REGRESSIONMATRIX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core/sample.h"
+#include "math/gemm.h"
+#include "regressiontable.h"
+
+/**
+ * @class RegressionMatrix
+ *
+ * Dense representation of the NumericPredictors and CategoricalPredictors of
+ * all the RegressionTables of a RegressionModel, used to compute their terms
+ * together.
+ *
+ * Each distinct pair of feature and exponent is a column, and the coefficients
+ * of the tables are stored as a row-major K x F matrix (K tables, F columns),
+ * with zeros for the columns a table doesn't use. The numeric terms of all
+ * tables are then a single matrix-vector product between the matrix and the
+ * values of the columns, gathered once from the sample. Blocks of samples are
+ * processed as a single matrix multiplication (see Gemm), which sums the
+ * products in another order: the terms of a sample scored in a block may
+ * differ from the ones of the same sample scored alone in the last bits.
+ *
+ * Columns are sorted by exponent: the ones with exponent 1 come first and are
+ * gathered as they are, integer exponents are computed by repeated
+ * multiplication, and only the others call std::pow. Missing values contribute
+ * zero, as in NumericPredictor.
+ *
+ * The levels of each categorical feature are encoded at load time into dense
+ * codes: the levels of all features are stored, sorted within each feature, in
+ * a single array, and the code of a level is its position there. The
+ * categorical coefficients are a row-major K x (L + 1) matrix indexed by code,
+ * whose last column is zero and is the code of missing and unseen levels. The
+ * codes of a sample are computed once for all the tables, and each table sums
+ * its coefficients with a single gather.
+ */
+class RegressionMatrix {
+ public:
+  enum : size_t { STACK_COLUMNS = 256 };  // above this number of columns, the gathered values are stored in the heap
+
+  size_t n_rows = 0;
+  size_t n_columns = 0;
+  size_t n_linear = 0;  // columns with exponent 1
+  std::vector<uint32_t> features;
+  std::vector<double> exponents;
+  std::vector<double> coefficients;
+  size_t n_levels = 0;  // L, also the code of missing and unseen levels
+  std::vector<uint32_t> categorical_features;
+  std::vector<uint32_t> level_offsets;  // code of the first level of each categorical feature, followed by L
+  std::vector<double> levels;
+  std::vector<double> categorical_coefficients;
+
+  RegressionMatrix() = default;
+
+  explicit RegressionMatrix(const std::vector<RegressionTable> &regression_tables) : n_rows(regression_tables.size()) {
+    std::vector<std::pair<uint32_t, double>> columns;
+    for (const auto &regression_table : regression_tables)
+      for (const auto &numeric_predictor : regression_table.numeric_predictors)
+        columns.push_back(std::make_pair(numeric_predictor.index, numeric_predictor.exponent));
+
+    // exponent 1 first, keeping the order of the predictors otherwise
+    std::stable_sort(columns.begin(), columns.end(),
+                     [](const std::pair<uint32_t, double> &a, const std::pair<uint32_t, double> &b) {
+                       return a.second == 1 && b.second != 1;
+                     });
+
+    std::unordered_map<uint32_t, std::vector<std::pair<double, size_t>>> positions;  // feature -> (exponent, column)
+    for (const auto &column : columns) {
+      if (find(positions, column.first, column.second) < n_columns) continue;
+
+      positions[column.first].push_back(std::make_pair(column.second, n_columns++));
+      features.push_back(column.first);
+      exponents.push_back(column.second);
+      if (column.second == 1) n_linear++;
+    }
+
+    coefficients.assign(n_rows * n_columns, 0);
+    for (auto i = 0u; i < n_rows; i++)
+      for (const auto &numeric_predictor : regression_tables[i].numeric_predictors)
+        coefficients[i * n_columns + find(positions, numeric_predictor.index, numeric_predictor.exponent)] +=
+            numeric_predictor.coefficient;
+
+    add_categorical_predictors(regression_tables);
+  }
+
+  // Values of the columns for sample, stored in values
+  inline void gather(const Sample &sample, double *values) const {
+    for (auto j = 0u; j < n_linear; j++) {
+      const Value &value = sample[features[j]].value;
+      values[j] = value.missing ? 0 : value.value;
+    }
+
+    for (auto j = n_linear; j < n_columns; j++) {
+      const Value &value = sample[features[j]].value;
+      values[j] = value.missing ? 0 : power(value.value, exponents[j]);
+    }
+  }
+
+  // Code of the level of the categorical feature f for sample
+  inline uint32_t encode(const Sample &sample, const size_t f) const {
+    const Value &value = sample[categorical_features[f]].value;
+    if (value.missing) return n_levels;
+
+    auto first = levels.cbegin() + level_offsets[f];
+    auto last = levels.cbegin() + level_offsets[f + 1];
+    auto level = std::lower_bound(first, last, value.value);
+
+    return level != last && *level == value.value ? level - levels.cbegin() : n_levels;
+  }
+
+  // Numeric and categorical terms of each table for sample, stored in terms
+  inline void multiply(const Sample &sample, double *terms) const {
+    if (n_columns <= STACK_COLUMNS) {
+      double values[STACK_COLUMNS];
+      gather(sample, values);
+      multiply(values, terms);
+    } else {
+      std::vector<double> values(n_columns);
+      gather(sample, values.data());
+      multiply(values.data(), terms);
+    }
+
+    add_categorical(sample, terms);
+  }
+
+  inline void multiply(const double *values, double *terms) const {
+    for (auto i = 0u; i < n_rows; i++) terms[i] = dot(&coefficients[i * n_columns], values, n_columns);
+  }
+
+  // Numeric and categorical terms of each table for the n samples, stored in terms as a row-major n x K matrix. The
+  // values of the samples are gathered in values, of size n x F.
+  inline void multiply(const Sample *samples, const size_t n, double *values, double *terms) const {
+    for (auto i = 0u; i < n; i++) gather(samples[i], values + i * n_columns);
+
+    gemm_nt(values, coefficients.data(), terms, n, n_rows, n_columns);
+    for (auto i = 0u; i < n; i++) add_categorical(samples[i], terms + i * n_rows);
+  }
+
+  // Categorical terms of each table for sample, added to terms
+  inline void add_categorical(const Sample &sample, double *terms) const {
+    if (categorical_features.empty()) return;
+
+    if (categorical_features.size() <= STACK_COLUMNS) {
+      uint32_t codes[STACK_COLUMNS];
+      add_categorical(sample, codes, terms);
+    } else {
+      std::vector<uint32_t> codes(categorical_features.size());
+      add_categorical(sample, codes.data(), terms);
+    }
+  }
+
+  inline void add_categorical(const Sample &sample, uint32_t *codes, double *terms) const {
+    const size_t n_features = categorical_features.size();
+    for (auto f = 0u; f < n_features; f++) codes[f] = encode(sample, f);
+
+    for (auto i = 0u; i < n_rows; i++) {
+      const double *row = &categorical_coefficients[i * (n_levels + 1)];
+      double result = 0;
+      for (auto f = 0u; f < n_features; f++) result += row[codes[f]];
+      terms[i] += result;
+    }
+  }
+
+  // Numeric and categorical terms of the first table, for models with a single table: the values are read directly
+  // from the sample
+  inline double multiply_first(const Sample &sample) const {
+    double result = 0;
+    for (auto j = 0u; j < n_linear; j++) {
+      const Value &value = sample[features[j]].value;
+      result += value.missing ? 0 : coefficients[j] * value.value;
+    }
+
+    for (auto j = n_linear; j < n_columns; j++) {
+      const Value &value = sample[features[j]].value;
+      result += value.missing ? 0 : coefficients[j] * power(value.value, exponents[j]);
+    }
+
+    for (auto f = 0u; f < categorical_features.size(); f++) result += categorical_coefficients[encode(sample, f)];
+
+    return result;
+  }
+
+  // Simple loop on contiguous memory, vectorized by the compiler. It is kept out of line so that the scoring paths
+  // calling it sum in the same order: with -Ofast each inlined copy could be reassociated differently. Blocks of
+  // samples are summed by gemm_nt instead, panel by panel and tile by tile, and multiply_first sums term by term.
+  __attribute__((noinline)) static double dot(const double *a, const double *b, const size_t n) {
+    double result = 0;
+    for (auto j = 0u; j < n; j++) result += a[j] * b[j];
+
+    return result;
+  }
+
+  inline static double power(const double value, const double exponent) {
+    if (exponent != std::floor(exponent) || std::abs(exponent) > 64) return std::pow(value, exponent);
+
+    double result = 1;
+    double base = value;
+    for (auto n = static_cast<uint32_t>(std::abs(exponent)); n > 0; n >>= 1) {
+      if (n & 1) result *= base;
+      base *= base;
+    }
+
+    return exponent < 0 ? 1 / result : result;
+  }
+
+ private:
+  inline void add_categorical_predictors(const std::vector<RegressionTable> &regression_tables) {
+    std::map<uint32_t, std::set<double>> feature_levels;
+    for (const auto &regression_table : regression_tables)
+      for (const auto &categorical_predictor : regression_table.categorical_predictors) {
+        if (feature_levels.find(categorical_predictor.index) == feature_levels.cend())
+          categorical_features.push_back(categorical_predictor.index);
+        for (const auto &coefficient : categorical_predictor.coefficients)
+          feature_levels[categorical_predictor.index].insert(coefficient.first);
+      }
+
+    for (const auto &feature : categorical_features) {
+      level_offsets.push_back(levels.size());
+      levels.insert(levels.end(), feature_levels[feature].cbegin(), feature_levels[feature].cend());
+    }
+    n_levels = levels.size();
+    level_offsets.push_back(n_levels);
+
+    categorical_coefficients.assign(n_rows * (n_levels + 1), 0);
+    for (auto i = 0u; i < n_rows; i++)
+      for (const auto &categorical_predictor : regression_tables[i].categorical_predictors) {
+        const size_t f = std::find(categorical_features.cbegin(), categorical_features.cend(),
+                                   categorical_predictor.index) -
+                         categorical_features.cbegin();
+        for (const auto &coefficient : categorical_predictor.coefficients) {
+          auto first = levels.cbegin() + level_offsets[f];
+          auto code = std::lower_bound(first, levels.cbegin() + level_offsets[f + 1], coefficient.first);
+          categorical_coefficients[i * (n_levels + 1) + (code - levels.cbegin())] += coefficient.second;
+        }
+      }
+  }
+
+  inline size_t find(const std::unordered_map<uint32_t, std::vector<std::pair<double, size_t>>> &positions,
+                     const uint32_t feature, const double exponent) const {
+    auto position = positions.find(feature);
+    if (position != positions.cend())
+      for (const auto &column : position->second)
+        if (column.first == exponent) return column.second;
+
+    return n_columns;
+  }
+};
+
+#endif
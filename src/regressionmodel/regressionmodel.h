@@ -16,6 +16,7 @@
 #include "core/xmlnode.h"
 #include "normalizationmethodbuilder.h"
 #include "normalizationmethodtype.h"
+#include "regressionmatrix.h"
 #include "regressionscore.h"
 #include "regressiontable.h"
 #include "treemodel/treescore.h"
@@ -31,11 +32,16 @@
  */
 class RegressionModel : public InternalModel {
  public:
+  enum : size_t { STACK_TABLES = 64 };
+
   NormalizationMethodType normalization_methodtype;
-  std::function<double(const double &)> regression_normalization;
-  std::function<std::vector<double>(const std::vector<double> &)> classification_normalization;
+  SingleNormalization regression_normalization;
+  SingleBatchNormalization regression_batch_normalization;
+  CategoricalNormalization classification_normalization;
   std::vector<RegressionTable> regression_tables;
-  std::vector<std::string> classes;
+  RegressionMatrix matrix;
+  std::vector<uint32_t> classes;  // label id of each regression table
+  std::vector<int> table_class_ids;
 
   RegressionModel() = default;
 
@@ -43,12 +49,17 @@ class RegressionModel : public InternalModel {
       : InternalModel(node, data_dictionary, indexer),
         normalization_methodtype(node.get_attribute("normalizationMethod")),
         regression_normalization(SingleNormalizationMethodBuilder::build(normalization_methodtype)),
+        regression_batch_normalization(SingleNormalizationMethodBuilder::build_batch(normalization_methodtype)),
         classification_normalization(MultiNormalizationMethodBuilder::build(normalization_methodtype)),
-        regression_tables(RegressionTable::to_regressiontables(node.get_childs("RegressionTable"), indexer)) {
+        regression_tables(RegressionTable::to_regressiontables(node.get_childs("RegressionTable"), indexer)),
+        matrix(regression_tables) {
     if (mining_function.value == MiningFunction::MiningFunctionType::CLASSIFICATION)
-      for (const auto &regression_table : regression_tables) classes.push_back(regression_table.target_category);
+      for (const auto &regression_table : regression_tables) {
+        table_class_ids.push_back(add_class(regression_table.target_category));
+        classes.push_back(class_labels[table_class_ids.back()]);
+      }
     else
-      classes.push_back(mining_schema.target.name);
+      classes.push_back(labels->add(mining_schema.target.name));
   }
 
   RegressionModel(const XmlNode &node, const DataDictionary &data_dictionary,
@@ -56,51 +67,191 @@ class RegressionModel : public InternalModel {
       : InternalModel(node, data_dictionary, transformationDictionary, indexer),
         normalization_methodtype(node.get_attribute("normalizationMethod")),
         regression_normalization(SingleNormalizationMethodBuilder::build(normalization_methodtype)),
+        regression_batch_normalization(SingleNormalizationMethodBuilder::build_batch(normalization_methodtype)),
         classification_normalization(MultiNormalizationMethodBuilder::build(normalization_methodtype)),
-        regression_tables(RegressionTable::to_regressiontables(node.get_childs("RegressionTable"), indexer)) {
+        regression_tables(RegressionTable::to_regressiontables(node.get_childs("RegressionTable"), indexer)),
+        matrix(regression_tables) {
     if (mining_function.value == MiningFunction::MiningFunctionType::CLASSIFICATION)
-      for (const auto &regression_table : regression_tables) classes.push_back(regression_table.target_category);
+      for (const auto &regression_table : regression_tables) {
+        table_class_ids.push_back(add_class(regression_table.target_category));
+        classes.push_back(class_labels[table_class_ids.back()]);
+      }
     else
-      classes.push_back(mining_schema.target.name);
+      classes.push_back(labels->add(mining_schema.target.name));
   }
 
   inline std::unique_ptr<InternalScore> score_raw(const Sample &sample) const override {
+    if (missing(sample)) return make_unique<InternalScore>();
+
     std::vector<double> scores;
     double regressed_value;
     switch (mining_function.value) {
       case MiningFunction::MiningFunctionType::REGRESSION:
-        scores.push_back(regression_normalization(regression_tables[0].score(sample)));
+        scores.push_back(regression_normalization(get_score(sample)));
         regressed_value = scores[0];
-        return make_unique<RegressionScore>(std::to_string(regressed_value), regressed_value, classes, scores);
+        return make_unique<RegressionScore>(std::to_string(regressed_value), regressed_value, labels, classes,
+                                           scores);
       case MiningFunction::MiningFunctionType::CLASSIFICATION:
-        scores = classification_normalization(get_scores(sample));
+        scores.resize(regression_tables.size());
+        get_probabilities(sample, scores.data());
         regressed_value = *std::max_element(scores.begin(), scores.end());
-        return make_unique<RegressionScore>(get_class(scores), regressed_value, classes, scores);
+        return make_unique<RegressionScore>(get_class(scores.data()), regressed_value, labels, classes, scores);
     }
 
     throw cpmml::ParsingException(mining_function.to_string() + "not available in RegressionModel");
   }
 
+  inline void score_into(const Sample &sample, InternalContext &context) const override {
+    if (missing(sample)) return context.score.assign(InternalScore());
+
+    std::vector<double> &scores = context.scores;
+    switch (mining_function.value) {
+      case MiningFunction::MiningFunctionType::REGRESSION:
+        scores.assign(1, regression_normalization(get_score(sample)));
+        context.score.assign(std::to_string(scores[0]));
+        break;
+      case MiningFunction::MiningFunctionType::CLASSIFICATION:
+        scores.resize(regression_tables.size());
+        get_probabilities(sample, scores.data());
+        context.score.assign(get_class(scores.data()));
+        break;
+      default:
+        throw cpmml::ParsingException(mining_function.to_string() + "not available in RegressionModel");
+    }
+
+    context.score.labels = labels;
+    context.score.probabilities.assign(labels->size(), double_min());
+    for (auto i = 0u; i < classes.size(); i++) context.score.probabilities[classes[i]] = scores[i];
+  }
+
   inline std::string predict_raw(const Sample &sample) const override {
+    if (missing(sample)) return std::string();
+
     switch (mining_function.value) {
       case MiningFunction::MiningFunctionType::REGRESSION:
-        return std::to_string(regression_normalization(regression_tables[0].score(sample)));
+        return std::to_string(regression_normalization(get_score(sample)));
       case MiningFunction::MiningFunctionType::CLASSIFICATION:
-        return get_class(classification_normalization(get_scores(sample)));
+        return regression_tables[predict_table(sample)].target_category;
     }
 
     throw cpmml::ParsingException(mining_function.to_string() + "not available in RegressionModel");
   }
 
-  inline std::vector<double> get_scores(const Sample &sample) const {
-    std::vector<double> scores;
+  inline bool predict_double_raw(const Sample &sample, double &predicted) const override {
+    if (mining_function.value != MiningFunction::MiningFunctionType::REGRESSION)
+      return InternalModel::predict_double_raw(sample, predicted);
+    if (missing(sample)) return false;
+
+    predicted = regression_normalization(get_score(sample));
+
+    return true;
+  }
+
+  inline size_t cost() const override { return (matrix.n_columns + 1) * regression_tables.size(); }
+
+  inline int predict_class_raw(const Sample &sample) const override {
+    return missing(sample) ? -1 : table_class_ids[predict_table(sample)];
+  }
+
+  // The scores of the block are computed together as a single matrix multiplication, see RegressionMatrix
+  inline void predict_block_raw(const Sample *samples, const size_t n, std::string *predictions) const override {
+    const size_t n_tables = regression_tables.size();
+    std::vector<double> scores(n * n_tables);
+    switch (mining_function.value) {
+      case MiningFunction::MiningFunctionType::REGRESSION:
+        get_scores(samples, n, scores.data());
+        get_values(scores.data(), n, scores.data());
+        for (auto i = 0u; i < n; i++)
+          predictions[i] = missing(samples[i]) ? std::string() : std::to_string(scores[i]);
+        return;
+      case MiningFunction::MiningFunctionType::CLASSIFICATION:
+        get_probabilities(samples, n, scores.data());
+        for (auto i = 0u; i < n; i++)
+          predictions[i] = missing(samples[i]) ? std::string() : get_class(&scores[i * n_tables]);
+        return;
+    }
 
-    for (const auto &regressionTable : regression_tables) scores.push_back(regressionTable.score(sample));
+    throw cpmml::ParsingException(mining_function.to_string() + "not available in RegressionModel");
+  }
+
+  inline void predict_double_block_raw(const Sample *samples, const size_t n, double *predictions,
+                                       uint8_t *found) const override {
+    if (mining_function.value != MiningFunction::MiningFunctionType::REGRESSION)
+      return InternalModel::predict_double_block_raw(samples, n, predictions, found);
+
+    const size_t n_tables = regression_tables.size();
+    std::vector<double> scores(n * n_tables);
+    get_scores(samples, n, scores.data());
+    get_values(scores.data(), n, predictions);
+    for (auto i = 0u; i < n; i++) found[i] = !missing(samples[i]);
+  }
+
+  // Index of the regression table of the predicted class. The scores are kept on the stack for up to STACK_TABLES
+  // tables.
+  inline size_t predict_table(const Sample &sample) const {
+    if (regression_tables.size() <= STACK_TABLES) {
+      double scores[STACK_TABLES];
+      get_probabilities(sample, scores);
+      return get_class_index(scores);
+    }
+
+    std::vector<double> scores(regression_tables.size());
+    get_probabilities(sample, scores.data());
+
+    return get_class_index(scores.data());
+  }
+
+  // Normalized scores of the regression tables, stored in scores
+  inline void get_probabilities(const Sample &sample, double *scores) const {
+    get_scores(sample, scores);
+    classification_normalization(scores, regression_tables.size());
+  }
+
+  inline void get_scores(const Sample &sample, double *scores) const {
+    matrix.multiply(sample, scores);
+    for (auto i = 0u; i < regression_tables.size(); i++) scores[i] = regression_tables[i].score(sample, scores[i]);
+  }
+
+  // Normalized scores of the regression tables for the n samples, stored in scores as a row-major n x K matrix
+  inline void get_probabilities(const Sample *samples, const size_t n, double *scores) const {
+    get_scores(samples, n, scores);
+    categorical_batch(classification_normalization, scores, n, regression_tables.size());
+  }
+
+  inline void get_scores(const Sample *samples, const size_t n, double *scores) const {
+    const size_t n_tables = regression_tables.size();
+    std::vector<double> values(n * matrix.n_columns);
+    matrix.multiply(samples, n, values.data(), scores);
+    for (auto i = 0u; i < n; i++)
+      for (auto j = 0u; j < n_tables; j++)
+        scores[i * n_tables + j] = regression_tables[j].score(samples[i], scores[i * n_tables + j]);
+  }
+
+  // Normalized values predicted for the n samples, from the scores of the first regression table in the row-major
+  // n x K matrix scores. values can be scores itself.
+  inline void get_values(const double *scores, const size_t n, double *values) const {
+    const size_t n_tables = regression_tables.size();
+    for (auto i = 0u; i < n; i++) values[i] = scores[i * n_tables];
+    regression_batch_normalization(values, values, n);
+  }
+
+  // Whether the prediction for sample is unknown, because of a PredictorTerm with a missing factor
+  inline bool missing(const Sample &sample) const {
+    for (const auto &regression_table : regression_tables)
+      if (regression_table.missing(sample)) return true;
+
+    return false;
+  }
+
+  inline double get_score(const Sample &sample) const {
+    return regression_tables[0].score(sample, matrix.multiply_first(sample));
+  }
 
-    return scores;
+  inline std::string get_class(const double *scores) const {
+    return regression_tables[get_class_index(scores)].target_category;
   }
 
-  inline std::string get_class(const std::vector<double> &scores) const {
+  inline size_t get_class_index(const double *scores) const {
     double max = -double_min();
     size_t _class = 0;
 
@@ -110,7 +261,7 @@ class RegressionModel : public InternalModel {
         _class = i;
       }
 
-    return regression_tables[_class].target_category;
+    return _class;
   }
 };
 
@@ -7,6 +7,7 @@
 #ifndef CPMML_REGRESSIONSCORE_H
 #define CPMML_REGRESSIONSCORE_H
 
+#include <memory>
 #include <vector>
 
 #include "core/internal_score.h"
@@ -19,13 +20,15 @@
  */
 class RegressionScore : public InternalScore {
  public:
-  RegressionScore(const std::string &simple_score, const double &simple_scored, const std::vector<std::string> &classes,
+  RegressionScore(const std::string &simple_score, const double &simple_scored,
+                  const std::shared_ptr<const LabelTable> &labels, const std::vector<uint32_t> &classes,
                   const std::vector<double> &scores)
-      : InternalScore(simple_score, get_probabilities(classes, scores)) {}
+      : InternalScore(simple_score, labels, get_probabilities(labels->size(), classes, scores)) {}
 
-  static std::unordered_map<std::string, double> get_probabilities(const std::vector<std::string> &classes,
-                                                                   const std::vector<double> &scores) {
-    std::unordered_map<std::string, double> probabilities;
+  // Scores of the classes, indexed by their label ids
+  static std::vector<double> get_probabilities(const size_t n_labels, const std::vector<uint32_t> &classes,
+                                               const std::vector<double> &scores) {
+    std::vector<double> probabilities(n_labels, double_min());
 
     for (auto i = 0u; i < classes.size(); i++) probabilities[classes[i]] = scores[i];
 
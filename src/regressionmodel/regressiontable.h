@@ -42,10 +42,16 @@ class RegressionTable {
         categorical_predictors(CategoricalPredictor::to_categoricalpredictors(node, indexer)),
         predictor_terms(PredictorTerm::to_predictorterms(node.get_childs("PredictorTerm"), indexer)) {}
 
-  inline double score(const Sample &sample) const {
-    double partial = 0;
-    for (const auto &numeric_predictor : numeric_predictors) partial += numeric_predictor.get_term(sample);
-    for (const auto &categorical_predictor : categorical_predictors) partial += categorical_predictor.get_term(sample);
+  // Whether a PredictorTerm is unknown for sample, so that the table has no score
+  inline bool missing(const Sample &sample) const {
+    for (const auto &predictor_term : predictor_terms)
+      if (predictor_term.missing(sample)) return true;
+
+    return false;
+  }
+
+  // Score given the sum of the numeric and categorical terms, computed elsewhere (see RegressionMatrix)
+  inline double score(const Sample &sample, double partial) const {
     for (const auto &predictor_term : predictor_terms) partial += predictor_term.get_term(sample);
 
     return intercept + partial;
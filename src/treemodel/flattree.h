@@ -0,0 +1,193 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_FLATTREE_H
+#define CPMML_FLATTREE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/labeltable.h"
+#include "core/predicateprogram.h"
+#include "core/sample.h"
+#include "leafpayloads.h"
+#include "missingvaluestrategy.h"
+#include "node.h"
+
+/**
+ * @class FlatTree
+ *
+ * Compiled representation of a tree of Node objects, used by TreeModel for
+ * scoring.
+ *
+ * Nodes are stored in depth-first pre-order, so that the first child of a node
+ * immediately follows it, and each property of the nodes is kept in its own
+ * array (struct of arrays). The predicates of all nodes are compiled into a
+ * single PredicateProgram, laid out in the same order as the nodes, while their
+ * scores are kept in LeafPayloads, referred to by id.
+ *
+ * The traversal is an iterative loop which walks the arrays, with the same
+ * semantics as the recursive visit of Node objects, including backtracking
+ * when no child matches and noTrueChildStrategy. A predicate unknown because
+ * of missing values is handled according to the missingValueStrategy of the
+ * tree: it doesn't match with none, gives no prediction with nullPrediction,
+ * returns the prediction of the parent with lastPrediction and goes on with
+ * the defaultChild of the parent with defaultChild (no prediction if it has
+ * none).
+ */
+class FlatTree {
+ public:
+  enum : uint32_t { none = std::numeric_limits<uint32_t>::max() };  // no node
+
+  bool return_last_prediction = false;
+  MissingValueStrategy missing_value_strategy;
+  PredicateProgram predicates;             // predicates of all nodes
+  std::vector<uint32_t> predicate_starts;  // first instruction in predicates of the predicate of each node
+  std::vector<uint8_t> leaves;
+  std::vector<uint32_t> next_siblings;  // none for the last child
+  std::vector<uint32_t> parents;
+  std::vector<uint32_t> default_children;  // none if the node has no defaultChild
+  std::vector<uint8_t> is_score;  // the node score has to be returned when found
+  std::vector<uint8_t> has_simple_score;
+  std::vector<uint32_t> payload_ids;  // payload of each node
+  std::vector<int> class_ids;
+  LeafPayloads payloads;
+
+  FlatTree() = default;
+
+  FlatTree(const Node &root, const bool return_last_prediction, const MissingValueStrategy &missing_value_strategy,
+           const std::shared_ptr<LabelTable> &labels)
+      : return_last_prediction(return_last_prediction), missing_value_strategy(missing_value_strategy) {
+    add_labels(root, *labels);
+    payloads = LeafPayloads(labels);
+
+    std::unordered_map<std::string, uint32_t> ids;
+    add_node(root, none, ids);
+    add_default_children(root, 0);
+  }
+
+  inline uint32_t size() const { return leaves.size(); }
+
+  // Number of nodes along the longest path from the root to a leaf, the root excluded
+  inline uint32_t depth() const {
+    std::vector<uint32_t> depths(size(), 0);
+    uint32_t result = 0;
+    for (auto node = 1u; node < size(); node++) {  // parents come before their children
+      depths[node] = depths[parents[node]] + 1;
+      result = std::max(result, depths[node]);
+    }
+
+    return result;
+  }
+
+  inline const std::string &score(const uint32_t node) const { return payloads.scores[payload_ids[node]]; }
+
+  inline double double_score(const uint32_t node) const { return payloads.double_scores[payload_ids[node]]; }
+
+  // Labels of the distributions of the nodes, children first, so that the rows of the payloads have a fixed size
+  static void add_labels(const Node &node, LabelTable &labels) {
+    for (const auto &child : node.children) add_labels(child, labels);
+    for (const auto &score_distribution : node.score_distributions) labels.add(score_distribution.value_string);
+  }
+
+  inline uint32_t add_node(const Node &node, const uint32_t parent, std::unordered_map<std::string, uint32_t> &ids) {
+    const uint32_t index = size();
+    predicate_starts.push_back(predicates.add(node.predicate));
+    leaves.push_back(node.leaf);
+    next_siblings.push_back(none);
+    parents.push_back(parent);
+    default_children.push_back(none);
+    is_score.push_back(true);
+    has_simple_score.push_back(node.simple_score != "");
+    payload_ids.push_back(payloads.add(node.simple_score, node.score_distributions, ids));
+    class_ids.push_back(-1);
+
+    uint32_t previous_child = none;
+    for (const auto &child : node.children) {
+      const uint32_t child_index = add_node(child, index, ids);
+      if (previous_child != none) next_siblings[previous_child] = child_index;
+      previous_child = child_index;
+    }
+
+    return index;
+  }
+
+  // Index of the defaultChild of each node, node being the index of the Node given
+  inline uint32_t add_default_children(const Node &node, const uint32_t index) {
+    uint32_t child_index = index + 1;
+    for (const auto &child : node.children) {
+      if (!node.default_child.empty() && child.id == node.default_child) default_children[index] = child_index;
+      child_index = add_default_children(child, child_index);
+    }
+
+    return child_index;
+  }
+
+  /**
+   * Index of the node holding the prediction for sample, none if there is no
+   * prediction. A node found is returned only if it is flagged in accepted,
+   * otherwise the search goes on with the following siblings (see is_score
+   * and has_simple_score).
+   */
+  inline uint32_t find(const Sample &sample, const std::vector<uint8_t> &accepted) const {
+    if (leaves[0]) return 0;
+
+    uint32_t parent = 0;
+    uint32_t node = 1;  // first child of the root
+    while (true) {
+      if (node != none) {
+        switch (predicates.evaluate(predicate_starts[node], sample)) {
+          case PredicateProgram::TRUE:
+            break;
+          case PredicateProgram::FALSE:
+            node = next_siblings[node];
+            continue;
+          case PredicateProgram::UNKNOWN:
+            switch (missing_value_strategy.value) {
+              case MissingValueStrategy::MissingValueStrategyValue::NONE:
+                node = next_siblings[node];
+                continue;
+              case MissingValueStrategy::MissingValueStrategyValue::LAST_PREDICTION:
+                return accepted[parent] ? parent : none;
+              case MissingValueStrategy::MissingValueStrategyValue::DEFAULT_CHILD:
+                node = default_children[parent];
+                if (node != none) break;
+                return none;
+              default:
+                return none;
+            }
+        }
+
+        if (!leaves[node]) {  // visit children
+          parent = node;
+          node = node + 1;
+          continue;
+        }
+        if (accepted[node]) return node;
+        node = next_siblings[node];
+        continue;
+      }
+
+      // no child of parent holds a prediction: backtrack
+      if (return_last_prediction && (parent == 0 || accepted[parent])) return parent;
+      if (parent == 0) return none;
+
+      node = next_siblings[parent];
+      parent = parents[parent];
+    }
+  }
+
+  inline uint32_t find_score(const Sample &sample) const { return find(sample, is_score); }
+
+  inline uint32_t find_simple_score(const Sample &sample) const { return find(sample, has_simple_score); }
+};
+
+#endif
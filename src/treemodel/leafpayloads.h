@@ -0,0 +1,100 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_LEAFPAYLOADS_H
+#define CPMML_LEAFPAYLOADS_H
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/internal_score.h"
+#include "core/labeltable.h"
+#include "scoredistribution.h"
+
+/**
+ * @class LeafPayloads
+ *
+ * Table of the scores of the nodes of a TreeModel.
+ *
+ * Each payload holds the score of a node, both as a string and as a double,
+ * and a dense row of probabilities indexed by the label ids of the model (see
+ * LabelTable). Nodes refer to their payload by id, and nodes with the same
+ * score and distribution share the same payload.
+ *
+ * The traversal of the tree only yields the id of a node: its payload is
+ * copied into an InternalScore only when the score is asked for, see assign.
+ */
+class LeafPayloads {
+ public:
+  enum : uint32_t { none = std::numeric_limits<uint32_t>::max() };  // no probabilities
+
+  std::shared_ptr<const LabelTable> labels;
+  size_t row_size = 0;  // number of labels when the table was built
+  std::vector<std::string> scores;
+  std::vector<double> double_scores;
+  std::vector<uint32_t> rows;         // first element in probabilities of the row of each payload
+  std::vector<double> probabilities;  // rows of row_size probabilities, double_min() when absent
+
+  LeafPayloads() = default;
+
+  explicit LeafPayloads(const std::shared_ptr<const LabelTable> &labels) : labels(labels), row_size(labels->size()) {}
+
+  inline uint32_t size() const { return scores.size(); }
+
+  // Id of the payload of score and score_distributions, added if not present. ids holds the payloads already added.
+  inline uint32_t add(const std::string &score, const std::vector<ScoreDistribution> &score_distributions,
+                      std::unordered_map<std::string, uint32_t> &ids) {
+    std::vector<double> row = get_probabilities(score_distributions);
+    std::string key(score);
+    key.push_back('\0');
+    key.append(reinterpret_cast<const char *>(row.data()), row.size() * sizeof(double));
+
+    auto id = ids.insert(std::make_pair(key, size()));
+    if (!id.second) return id.first->second;
+
+    scores.push_back(score);
+    double double_score;
+    double_scores.push_back(try_to_double(score, double_score) ? double_score : double_min());
+    rows.push_back(row.empty() ? uint32_t(none) : uint32_t(probabilities.size()));
+    probabilities.insert(probabilities.end(), row.cbegin(), row.cend());
+
+    return id.first->second;
+  }
+
+  // Copies the payload into score, keeping the memory already allocated by score
+  inline void assign(const uint32_t payload, InternalScore &score) const {
+    score.empty = false;
+    score.score = scores[payload];
+    score.double_score = double_scores[payload];
+    score.labels = labels;
+    if (rows[payload] == none)
+      score.probabilities.clear();
+    else
+      score.probabilities.assign(probabilities.cbegin() + rows[payload],
+                                 probabilities.cbegin() + rows[payload] + row_size);
+  }
+
+  // Probabilities indexed by label id, empty with no distribution. The labels must be already in the table.
+  inline std::vector<double> get_probabilities(const std::vector<ScoreDistribution> &score_distributions) const {
+    if (score_distributions.empty()) return std::vector<double>();
+
+    std::vector<double> probabilities(row_size, double_min());
+    double total = 0;
+    for (const auto &score_distribution : score_distributions) total += score_distribution.record_count;
+
+    for (const auto &score_distribution : score_distributions)
+      probabilities[labels->find(score_distribution.value_string)] = score_distribution.record_count / total;
+
+    return probabilities;
+  }
+};
+
+#endif
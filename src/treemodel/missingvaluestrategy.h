@@ -0,0 +1,82 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_MISSINGVALUESTRATEGY_H
+#define CPMML_MISSINGVALUESTRATEGY_H
+
+#include <string>
+#include <unordered_map>
+#include "utils/utils.h"
+
+/**
+ * @class MissingValueStrategy
+ *
+ * Class representing <a
+ * href="http://dmg.org/pmml/v4-4/TreeModel.html#xsdType_MISSING-VALUE-STRATEGY">PMML
+ * MISSING-VALUE-STRATEGY</a>.
+ *
+ * It defines how a TreeModel goes on when the predicate of a node is unknown
+ * because of missing values. weightedConfidence and aggregateNodes are not
+ * supported, and behave as nullPrediction.
+ */
+class MissingValueStrategy {
+ public:
+  enum class MissingValueStrategyValue {
+    NONE,
+    NULL_PREDICTION,
+    LAST_PREDICTION,
+    DEFAULT_CHILD,
+    WEIGHTED_CONFIDENCE,
+    AGGREGATE_NODES
+  };
+
+  MissingValueStrategyValue value = MissingValueStrategyValue::NONE;
+
+  MissingValueStrategy() = default;
+
+  explicit MissingValueStrategy(const std::string &value) : value(from_string(to_lower(value))) {}
+
+  inline bool operator==(const MissingValueStrategy &other) const { return value == other.value; };
+
+  inline bool operator!=(const MissingValueStrategy &other) const { return value != other.value; };
+
+  static MissingValueStrategyValue from_string(const std::string &missingvaluestrategy) {
+    const static std::unordered_map<std::string, MissingValueStrategyValue> missingvaluestrategy_converter = {
+        {"none", MissingValueStrategyValue::NONE},
+        {"nullprediction", MissingValueStrategyValue::NULL_PREDICTION},
+        {"lastprediction", MissingValueStrategyValue::LAST_PREDICTION},
+        {"defaultchild", MissingValueStrategyValue::DEFAULT_CHILD},
+        {"weightedconfidence", MissingValueStrategyValue::WEIGHTED_CONFIDENCE},
+        {"aggregatenodes", MissingValueStrategyValue::AGGREGATE_NODES}};
+
+    try {
+      return missingvaluestrategy_converter.at(to_lower(missingvaluestrategy));
+    } catch (const std::out_of_range &exception) {
+      return MissingValueStrategyValue::NONE;
+    }
+  }
+
+  std::string to_string() const {
+    switch (value) {
+      case MissingValueStrategyValue::NONE:
+        return "none";
+      case MissingValueStrategyValue::NULL_PREDICTION:
+        return "nullPrediction";
+      case MissingValueStrategyValue::LAST_PREDICTION:
+        return "lastPrediction";
+      case MissingValueStrategyValue::DEFAULT_CHILD:
+        return "defaultChild";
+      case MissingValueStrategyValue::WEIGHTED_CONFIDENCE:
+        return "weightedConfidence";
+      case MissingValueStrategyValue::AGGREGATE_NODES:
+        return "aggregateNodes";
+      default:
+        return "none";
+    }
+  }
+};
+
+#endif
@@ -12,11 +12,9 @@
 #include <string>
 #include <vector>
 
-#include "core/fastpredicate.h"
 #include "core/predicatebuilder.h"
 #include "core/xmlnode.h"
 #include "scoredistribution.h"
-#include "treescore.h"
 
 /**
  * @class Node
@@ -24,37 +22,36 @@
  * Class representing <a
  * href="http://dmg.org/pmml/v4-4/TreeModel.html#xsdElement_Node">PMML Node</a>.
  *
- * It is a node of the decision tree, containing a Predicate and a TreeScore.
- * The score represents the prediction associated to a sample matching the
- * predicate.
+ * It is a node of the decision tree, containing a Predicate, a score and its
+ * ScoreDistributions. The score represents the prediction associated to a
+ * sample matching the predicate. Nodes are only used while loading: they are
+ * compiled into a FlatTree, which keeps the scores in LeafPayloads.
  */
 class Node {
  public:
-  //    std::string id;
+  std::string id;
   std::string simple_score;
   double record_count = double_min();
-  //    std::string default_child;
+  std::string default_child;  // id of the child followed by missingValueStrategy defaultChild, empty if none
   std::vector<Node> children;
-  std::function<bool(const Sample &)> predicate;
+  Predicate predicate;
   bool root = false;
   bool leaf = false;
-  TreeScore score;
+  std::vector<ScoreDistribution> score_distributions;
 
   Node() = default;
 
-  Node(const XmlNode &node, bool root, const PredicateBuilder &predicate_builder,
-       const DataType &target_datatype)
-      :  //        id(node.get_attribute("id")),
+  Node(const XmlNode &node, bool root, const PredicateBuilder &predicate_builder, const DataType &target_datatype)
+      : id(node.exists_attribute("id") ? node.get_attribute("id") : ""),
         simple_score(node.exists_attribute("score") ? node.get_attribute("score") : ""),
         record_count(node.get_double_attribute("recordCount")),
-        //        default_child(node.get_attribute("defaultChild")),
+        default_child(node.exists_attribute("defaultChild") ? node.get_attribute("defaultChild") : ""),
         children(to_nodes(node.get_childs("Node"), predicate_builder, target_datatype)),
-        predicate(to_function(predicate_builder.build(node.get_child_bypattern("Predicate")))),
+        predicate(predicate_builder.build(node.get_child_bypattern("Predicate"))),
         root(root),
         leaf(children.size() == 0),
-        score(simple_score, target_datatype, node.get_childs("ScoreDistribution")){};
-
-  constexpr bool match(const Sample &sample) const { return predicate(sample); }
+        score_distributions(
+            ScoreDistribution::to_score_distributions(node.get_childs("ScoreDistribution"), target_datatype)){};
 
   static std::vector<Node> to_nodes(const std::vector<XmlNode> &nodes, const PredicateBuilder &predicateBuilder,
                                     const DataType &target_datatype) {
@@ -29,7 +29,9 @@ class TreeEvaluator : public InternalEvaluator {
 
   TreeModel tree;
 
-  inline bool validate(const std::unordered_map<std::string, std::string> &sample) { return tree.validate(sample); }
+  inline bool validate(const std::unordered_map<std::string, std::string> &sample) const override {
+    return tree.validate(sample);
+  }
 
   inline std::unique_ptr<InternalScore> score(
       const std::unordered_map<std::string, std::string> &sample) const override {
@@ -42,6 +44,8 @@ class TreeEvaluator : public InternalEvaluator {
   }
 
   inline std::string get_target_name() const override { return tree.target_field.name; };
+
+  inline const InternalModel &get_model() const override { return tree; }
 };
 
 #endif
@@ -16,9 +16,10 @@
 #include "core/miningfield.h"
 #include "core/miningfunction.h"
 #include "core/miningschema.h"
-#include "core/string_view.h"
 #include "core/xmlnode.h"
+#include "flattree.h"
 #include "node.h"
+#include "treescore.h"
 
 /**
  * @class TreeModel
@@ -32,7 +33,8 @@
 class TreeModel : public InternalModel {
  public:
   bool return_last_prediction = false;
-  Node root_node;
+  MissingValueStrategy missing_value_strategy;
+  FlatTree tree;
 
   TreeModel() = default;
 
@@ -40,81 +42,66 @@ class TreeModel : public InternalModel {
             const std::shared_ptr<Indexer> &indexer)
       : InternalModel(node, data_dictionary, indexer),
         return_last_prediction(node.get_attribute("noTrueChildStrategy") == "returnLastPrediction"),
-        root_node(Node(node.get_child("Node"), true, predicate_builder, target_field.datatype)){};
+        missing_value_strategy(node.get_attribute("missingValueStrategy")),
+        tree(Node(node.get_child("Node"), true, predicate_builder, target_field.datatype), return_last_prediction,
+             missing_value_strategy, labels) {
+    if (mining_function.value == MiningFunction::MiningFunctionType::CLASSIFICATION) index_classes();
+  };
 
   TreeModel(const XmlNode &node, const DataDictionary &data_dictionary,
             const TransformationDictionary &transformationDictionary, const std::shared_ptr<Indexer> &indexer)
       : InternalModel(node, data_dictionary, transformationDictionary, indexer),
         return_last_prediction(node.get_attribute("noTrueChildStrategy") == "returnLastPrediction"),
-        root_node(Node(node.get_child("Node"), true, PredicateBuilder(indexer), target_field.datatype)){};
-
-  inline std::unique_ptr<InternalScore> score_raw(const Sample &sample) const override {
-    return make_unique<TreeScore>(scoreR(sample, root_node));
-  };
-
-  inline std::string predict_raw(const Sample &sample) const override {
-    return simple_scoreR(sample, root_node).to_string();
+        missing_value_strategy(node.get_attribute("missingValueStrategy")),
+        tree(Node(node.get_child("Node"), true, PredicateBuilder(indexer), target_field.datatype),
+             return_last_prediction, missing_value_strategy, labels) {
+    if (mining_function.value == MiningFunction::MiningFunctionType::CLASSIFICATION) index_classes();
   };
 
-  inline TreeScore scoreR(const Sample &sample, const Node &current_node) const {
-#ifdef DEBUG
-    static int depth = 0;
-    //        depth++;
-    std::cout << std::string(depth, '\t') << current_node.predicate << (current_node.leaf ? " !!! MATCH !!!" : "")
-              << std::endl;
-//        if(current_node.leaf)
-//            depth--;
-#endif
+  inline void index_classes() {
+    for (auto i = 0u; i < tree.size(); i++)
+      if (tree.has_simple_score[i]) tree.class_ids[i] = add_class(tree.score(i));
+  }
 
-    TreeScore result;
+  inline std::unique_ptr<InternalScore> score_raw(const Sample &sample) const override {
+    const uint32_t leaf = tree.find_score(sample);
 
-    if (current_node.leaf) return current_node.score;
+    if (leaf == FlatTree::none) return make_unique<TreeScore>();
 
-    for (const auto &child : current_node.children)
-      if (child.match(sample)) {
-#ifdef DEBUG
-        depth++;
-#endif
-        result = scoreR(sample, child);
+    return make_unique<TreeScore>(tree.payloads, tree.payload_ids[leaf]);
+  };
 
-#ifdef DEBUG
-        depth--;
-//                if(result.score != "") depth--;
-#endif
-        if (result.is_score) return result;
-      }
+  inline void score_into(const Sample &sample, InternalContext &context) const override {
+    const uint32_t leaf = tree.find_score(sample);
+    if (leaf != FlatTree::none)
+      tree.payloads.assign(tree.payload_ids[leaf], context.score);
+    else
+      context.score.assign(TreeScore());
+  };
 
-    if (return_last_prediction) return current_node.score;
+  inline bool predict_double_raw(const Sample &sample, double &predicted) const override {
+    const uint32_t leaf = tree.find_score(sample);
+    if (leaf == FlatTree::none || !tree.has_simple_score[leaf]) return false;
 
-    return TreeScore();
-  }
+    predicted = tree.double_score(leaf);
 
-  inline string_view simple_scoreR(const Sample &sample, const Node &current_node) const {
-#ifdef DEBUG
-    static int depth = 0;
-    depth++;
-    std::cout << std::string(depth, '\t') << current_node.predicate << (current_node.leaf ? " !!! MATCH !!!" : "")
-              << std::endl;
-    if (current_node.leaf) depth--;
-#endif
+    return true;
+  };
 
-    string_view result;
+  inline int predict_class_raw(const Sample &sample) const override {
+    const uint32_t leaf = tree.find_score(sample);
 
-    if (current_node.leaf) return string_view(current_node.simple_score);
+    return leaf == FlatTree::none ? -1 : tree.class_ids[leaf];
+  };
 
-    for (const auto &child : current_node.children)
-      if (child.match(sample)) {
-        result = simple_scoreR(sample, child);
-#ifdef DEBUG
-        if (result != "") depth--;
-#endif
-        if (result != string_view()) return result;
-      }
+  // Predicates evaluated along the deepest path, assuming two children per node
+  inline size_t cost() const override { return 2 * tree.depth() + 1; }
 
-    if (return_last_prediction) return string_view(current_node.simple_score);
+  inline std::string predict_raw(const Sample &sample) const override {
+    const uint32_t leaf = tree.find_simple_score(sample);
 
-    return result;
-  }
+    return leaf == FlatTree::none ? std::string() : tree.score(leaf);
+  };
 };
 
 #endif
@@ -0,0 +1,139 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_MAPPEDFILE_H
+#define CPMML_MAPPEDFILE_H
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "cPMML.h"
+
+/**
+ * @class MappedFile
+ *
+ * Memory mapping of a whole file, unmapped when the object is destroyed.
+ *
+ * Pages are loaded by the system as they are accessed, and shared with the
+ * page cache: mapping a file costs neither a copy nor an allocation of its
+ * size. A COPY_ON_WRITE mapping can be written too, as rapidxml does while
+ * parsing in place: only the pages written are copied, and the file is left
+ * untouched.
+ *
+ * Files are mapped with mmap on POSIX systems, and with CreateFileMapping and
+ * MapViewOfFile on Windows.
+ */
+class MappedFile {
+ public:
+  enum class Access : uint8_t { READ_ONLY, COPY_ON_WRITE };
+
+  MappedFile() = default;
+
+#ifdef _WIN32
+  explicit MappedFile(const std::string &filepath, const Access access = Access::READ_ONLY) {
+    const HANDLE file = ::CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                      FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw cpmml::ParsingException("Input file " + filepath + " does not exist");
+
+    LARGE_INTEGER file_size;
+    if (!::GetFileSizeEx(file, &file_size)) {
+      ::CloseHandle(file);
+      throw cpmml::ParsingException("Input file " + filepath + " cannot be read");
+    }
+
+    length = static_cast<size_t>(file_size.QuadPart);
+    if (length != 0) {  // empty files cannot be mapped
+      const bool copy_on_write = access == Access::COPY_ON_WRITE;
+      const HANDLE mapping =
+          ::CreateFileMappingA(file, nullptr, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+      void *address = mapping ? ::MapViewOfFile(mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0)
+                              : nullptr;
+      if (mapping) ::CloseHandle(mapping);  // the view keeps the mapping alive
+      if (!address) {
+        ::CloseHandle(file);
+        throw cpmml::ParsingException("Input file " + filepath + " cannot be mapped");
+      }
+      bytes = static_cast<char *>(address);
+    }
+    ::CloseHandle(file);
+  }
+
+  ~MappedFile() {
+    if (bytes) ::UnmapViewOfFile(bytes);
+  }
+#else
+  explicit MappedFile(const std::string &filepath, const Access access = Access::READ_ONLY) {
+    const int descriptor = ::open(filepath.c_str(), O_RDONLY);
+    if (descriptor < 0) throw cpmml::ParsingException("Input file " + filepath + " does not exist");
+
+    struct stat status;
+    if (::fstat(descriptor, &status) != 0) {
+      ::close(descriptor);
+      throw cpmml::ParsingException("Input file " + filepath + " cannot be read");
+    }
+
+    length = static_cast<size_t>(status.st_size);
+    if (length != 0) {
+      const int protection = access == Access::COPY_ON_WRITE ? PROT_READ | PROT_WRITE : PROT_READ;
+      void *address = ::mmap(nullptr, length, protection, MAP_PRIVATE, descriptor, 0);
+      if (address == MAP_FAILED) {
+        ::close(descriptor);
+        throw cpmml::ParsingException("Input file " + filepath + " cannot be mapped");
+      }
+      bytes = static_cast<char *>(address);
+    }
+    ::close(descriptor);  // the mapping stays valid
+  }
+
+  ~MappedFile() {
+    if (bytes) ::munmap(bytes, length);
+  }
+#endif
+
+  MappedFile(const MappedFile &) = delete;
+
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  inline const char *data() const { return bytes; }
+
+  // Writable only for COPY_ON_WRITE mappings
+  inline char *data() { return bytes; }
+
+  inline size_t size() const { return length; }
+
+  // Whether the mapping is followed by a null byte: the end of the last page, past the end of the file, reads as zeros
+  inline bool null_terminated() const { return bytes && length % page_size() != 0; }
+
+ private:
+  char *bytes = nullptr;
+  size_t length = 0;
+
+  inline static size_t page_size() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+
+    return info.dwPageSize;
+#else
+    return ::sysconf(_SC_PAGESIZE);
+#endif
+  }
+};
+
+#endif
@@ -0,0 +1,108 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_MPMCQUEUE_H
+#define CPMML_MPMCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+/**
+ * @class MPMCQueue
+ *
+ * Bounded lock-free queue with multiple producers and multiple consumers,
+ * used to hand the requests of cpmml::Model::score_async to the workers of
+ * AsyncScorer.
+ *
+ * The queue is a ring of cells, each tagged with a sequence number telling
+ * whether it is ready to be written or read in the current lap. Producers and
+ * consumers claim a position by a compare and swap on their own counter, then
+ * publish the cell through its sequence number: no thread ever waits for
+ * another one, and a full or empty queue is reported rather than waited for.
+ *
+ * The capacity is rounded up to a power of two.
+ */
+template <class T>
+class MPMCQueue {
+ public:
+  enum : size_t { CACHE_LINE = 64 };
+
+  explicit MPMCQueue(const size_t min_capacity) : mask(round_up(min_capacity) - 1), cells(new Cell[mask + 1]) {
+    for (auto i = 0u; i <= mask; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  MPMCQueue(const MPMCQueue &) = delete;
+
+  MPMCQueue &operator=(const MPMCQueue &) = delete;
+
+  inline size_t capacity() const { return mask + 1; }
+
+  // Appends value to the queue, returning false if it is full
+  inline bool try_push(const T &value) {
+    size_t position = tail.value.load(std::memory_order_relaxed);
+    while (true) {
+      Cell &cell = cells[position & mask];
+      const ptrdiff_t lag = ptrdiff_t(cell.sequence.load(std::memory_order_acquire) - position);
+      if (lag == 0) {
+        if (tail.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          cell.value = value;
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lag < 0) {  // the cell of the previous lap hasn't been read yet
+        return false;
+      } else {
+        position = tail.value.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Takes the first value of the queue, returning false if it is empty
+  inline bool try_pop(T &value) {
+    size_t position = head.value.load(std::memory_order_relaxed);
+    while (true) {
+      Cell &cell = cells[position & mask];
+      const ptrdiff_t lag = ptrdiff_t(cell.sequence.load(std::memory_order_acquire) - (position + 1));
+      if (lag == 0) {
+        if (head.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          value = cell.value;
+          cell.sequence.store(position + mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lag < 0) {  // the cell hasn't been written yet
+        return false;
+      } else {
+        position = head.value.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  struct Counter {
+    std::atomic<size_t> value{0};
+    char padding[CACHE_LINE - sizeof(std::atomic<size_t>)];
+  };
+
+  Counter head;  // next position to read
+  Counter tail;  // next position to write
+  const size_t mask;
+  std::unique_ptr<Cell[]> cells;
+
+  inline static size_t round_up(const size_t min_capacity) {
+    size_t capacity = 2;
+    while (capacity < min_capacity) capacity <<= 1;
+
+    return capacity;
+  }
+};
+
+#endif
@@ -0,0 +1,227 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_THREADPOOL_H
+#define CPMML_THREADPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef MULTITHREADING
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+/**
+ * @class ThreadPool
+ *
+ * Persistent pool of threads running the tasks of a job, used to split the
+ * segments of large ensembles while scoring a single sample (see
+ * MultipleModelMethod).
+ *
+ * The workers are started once and wait for jobs, spinning for a while before
+ * sleeping, so that a job doesn't pay for the creation of threads. The thread
+ * submitting a job takes part in it, and returns when all of its tasks are
+ * done. Tasks are taken in order from a shared counter, tagged with the
+ * generation of the job: when the job is over its counter is closed, so that a
+ * late worker can't take a task of the next one.
+ *
+ * Only one job runs at a time: a job submitted while the pool is busy with
+ * another one is run by the submitting thread alone. Since the tasks of a job
+ * write to their own slots, the result doesn't depend on which threads ran
+ * them.
+ *
+ * Jobs submitted within a ThreadPool::Serial scope, as by the workers scoring
+ * the rows of a batch in parallel, are run by the submitting thread alone too.
+ *
+ * Without MULTITHREADING the pool has no worker, and jobs are always run by
+ * the submitting thread.
+ */
+class ThreadPool {
+ public:
+  enum : size_t { CACHE_LINE = 64, SPIN = 1 << 12 };
+  enum : uint64_t { CLOSED = 0xFFFFFFFF };  // task counter of a job which is over
+
+  /**
+   * Scope in which the jobs submitted by the current thread are run by the
+   * thread alone, when the thread is already one of several working in
+   * parallel.
+   */
+  class Serial {
+   public:
+    explicit Serial(const bool enabled = true) : previous(current()) { current() = previous || enabled; }
+
+    ~Serial() { current() = previous; }
+
+    inline static bool &current() {
+      static thread_local bool serial = false;
+
+      return serial;
+    }
+
+   private:
+    bool previous;
+  };
+
+#ifndef MULTITHREADING
+  explicit ThreadPool(const size_t n_threads = 1) {}
+
+  inline size_t size() const { return 1; }
+
+  inline void resize(const size_t n_threads) {}
+
+  template <class Task>
+  inline void run(const size_t n_tasks, const Task &task) {
+    for (auto i = 0u; i < n_tasks; i++) task(i);
+  }
+
+  inline static ThreadPool &instance() {
+    static ThreadPool pool;
+
+    return pool;
+  }
+#else
+  explicit ThreadPool(const size_t n_threads = NUM_THREADS) { start(n_threads); }
+
+  ~ThreadPool() { stop(); }
+
+  ThreadPool(const ThreadPool &) = delete;
+
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Number of threads running a job, including the submitting one
+  inline size_t size() const { return n_workers.load(std::memory_order_relaxed) + 1; }
+
+  inline void resize(const size_t n_threads) {
+    std::lock_guard<std::mutex> job_lock(job_mutex);
+    stop();
+    start(n_threads);
+  }
+
+  // Runs task(i) for each i in [0, n_tasks), returning when all of them are done
+  template <class Task>
+  inline void run(const size_t n_tasks, const Task &task) {
+    std::unique_lock<std::mutex> job_lock(job_mutex, std::try_to_lock);
+    if (Serial::current() || !job_lock.owns_lock() || workers.empty() || n_tasks < 2) {
+      for (auto i = 0u; i < n_tasks; i++) task(i);
+      return;
+    }
+
+    const uint64_t job_generation = generation(next.load()) + 1;
+    context.store(&task);
+    call.store(&call_task<Task>);
+    tasks.store(n_tasks);
+    pending.store(n_tasks);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      next.store(job_generation << 32);
+    }
+    wake.notify_all();
+
+    work(job_generation);
+    while (pending.load() != 0) std::this_thread::yield();
+    next.store((job_generation << 32) | CLOSED);
+
+    if (error) {
+      std::exception_ptr job_error = error;
+      error = nullptr;
+      std::rethrow_exception(job_error);
+    }
+  }
+
+  // Pool shared by all models, see cpmml::set_num_threads
+  inline static ThreadPool &instance() {
+    static ThreadPool pool;
+
+    return pool;
+  }
+
+ private:
+  std::vector<std::thread> workers;
+  std::atomic<size_t> n_workers{0};
+  std::mutex job_mutex;  // held while a job runs
+  std::mutex mutex;      // guards the wake up of the workers
+  std::condition_variable wake;
+  bool stopping = false;
+  std::atomic<uint64_t> next{0};  // generation of the job in the high 32 bits, next task in the low 32 bits
+  std::atomic<const void *> context{nullptr};
+  std::atomic<void (*)(const void *, size_t)> call{nullptr};
+  std::atomic<size_t> tasks{0};
+  std::atomic<size_t> pending{0};
+  std::exception_ptr error;  // first exception thrown by a task of the job
+
+  inline static uint64_t generation(const uint64_t value) { return value >> 32; }
+
+  inline static uint64_t index(const uint64_t value) { return value & CLOSED; }
+
+  template <class Task>
+  static void call_task(const void *context, const size_t i) {
+    (*static_cast<const Task *>(context))(i);
+  }
+
+  inline void start(const size_t n_threads) {
+    for (auto i = 1u; i < n_threads; i++) workers.emplace_back(&ThreadPool::loop, this);
+    n_workers.store(workers.size(), std::memory_order_relaxed);
+  }
+
+  inline void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers) worker.join();
+
+    workers.clear();
+    n_workers.store(0, std::memory_order_relaxed);
+    stopping = false;
+  }
+
+  inline void loop() {
+    uint64_t seen = generation(next.load());
+    while (true) {
+      uint64_t current = seen;
+      for (auto spin = 0u; spin < SPIN && current == seen; spin++) current = generation(next.load());
+
+      if (current == seen) {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return stopping || generation(next.load()) != seen; });
+        if (stopping) return;
+        current = generation(next.load());
+      }
+
+      seen = current;
+      work(seen);
+    }
+  }
+
+  // Runs tasks of the job of generation job_generation, as long as there are any left. The operations on the job are
+  // sequentially consistent: a task taken is always run with the context of its own job.
+  inline void work(const uint64_t job_generation) {
+    uint64_t task = next.load();
+    while (generation(task) == job_generation && index(task) < tasks.load()) {
+      const void *task_context = context.load();
+      void (*task_call)(const void *, size_t) = call.load();
+      if (!next.compare_exchange_weak(task, task + 1)) continue;
+
+      try {
+        task_call(task_context, index(task));
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) error = std::current_exception();
+      }
+      pending.fetch_sub(1);
+      task = next.load();
+    }
+  }
+#endif
+};
+
+#endif
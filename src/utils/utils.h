@@ -9,10 +9,14 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <memory>
 #include <set>
 #include <sstream>
 #include <string>
@@ -21,8 +25,6 @@
 #include <vector>
 #include "options.h"
 
-#include "miniz/miniz.h"
-
 /**
  * @defgroup Utils
  *
@@ -45,6 +47,20 @@ inline static double to_double(const std::string &value) {
   }
 }
 
+// same conversion as to_double, but failures are signalled through the return value rather than with an exception
+inline bool try_to_double(const std::string &value, double &result) {
+  const char *begin = value.c_str();
+  char *end;
+  const int saved_errno = errno;
+  errno = 0;
+  const double parsed = std::strtod(begin, &end);
+  const bool converted = end != begin && errno != ERANGE;
+  if (errno == 0) errno = saved_errno;
+  if (converted) result = parsed;
+
+  return converted;
+}
+
 template <class T>
 T parse_string(const std::string &value) {
   std::istringstream is(to_lower(value));
@@ -215,53 +231,11 @@ static inline std::string &rtrim(std::string &s) {
 // trim from both ends
 static inline std::string &trim(std::string &s) { return ltrim(rtrim(s)); }
 
-static inline std::vector<char> read_xml(const std::string &filepath) {
-  std::ifstream file(filepath);
-  std::vector<char> data((std::istreambuf_iterator<char>(file)), {});
-  data.push_back('\0');
-
-  return data;
-}
-
-static inline void mz_reader_error(mz_zip_archive *zip_archive, const std::string &message) {
-  mz_zip_reader_end(zip_archive);
-  throw cpmml::ParsingException("unzip - err: " + message);
-}
-
-static inline std::vector<char> read_zip(const std::string &filepath) {
-  mz_zip_archive zip_archive;
-  size_t inflated_size;
-  void *p;
-
-  memset(&zip_archive, 0, sizeof(zip_archive));
-  if (mz_zip_reader_init_file(&zip_archive, filepath.c_str(), 0) != MZ_STREAM_END)
-    throw cpmml::ParsingException("unzip - err: reading archive");
-  if (mz_zip_reader_get_num_files(&zip_archive) < 1) mz_reader_error(&zip_archive, "no file in archive");
-  if (mz_zip_reader_is_file_a_directory(&zip_archive, 0)) mz_reader_error(&zip_archive, "directory in archive");
-  if ((p = mz_zip_reader_extract_to_heap(&zip_archive, 0, &inflated_size, 0)) == NULL)
-    mz_reader_error(&zip_archive, "decompressing");
-  std::vector<char> data((char *)p, (char *)p + inflated_size);
-  data.push_back('\0');
-
-  mz_free(p);
-  mz_zip_reader_end(&zip_archive);
-
-  return data;
-}
-
 static inline bool file_exists(const std::string &name) {
   std::ifstream f(name.c_str());
   return f.good();
 }
 
-static inline std::vector<char> read_file(const std::string &filepath, const bool zipped) {
-  if (!file_exists(filepath)) throw cpmml::ParsingException("Input file " + filepath + " does not exist");
-
-  if (zipped) return read_zip(filepath);
-
-  return read_xml(filepath);
-}
-
 template <class T>
 inline std::string format_num(const T &value) {
   std::stringstream sstr_value;
@@ -0,0 +1,147 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_WORKSTEALING_H
+#define CPMML_WORKSTEALING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+
+#ifdef MULTITHREADING
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+#endif
+
+/**
+ * @class WorkStealing
+ *
+ * Scheduler of n_items independent items among a number of workers, each
+ * running on its own thread, used to split the rows of a large batch (see
+ * cpmml::Model::score_batch_parallel).
+ *
+ * The items are dealt out as contiguous ranges, one per worker. A worker takes
+ * items from the front of its own range and, once it is over, steals the back
+ * half of the range of another worker. A range is a single atomic word, so
+ * taking or stealing an item is a compare and swap. Workers leave when they
+ * find no range left to steal from.
+ *
+ * The workers are started by run, the calling thread being worker 0, and run
+ * returns when all of them are done. Without MULTITHREADING there is only
+ * worker 0.
+ */
+class WorkStealing {
+ public:
+  enum : size_t { CACHE_LINE = 64 };
+
+  WorkStealing(const size_t n_items, const size_t n_threads)
+      : n_workers(std::max<size_t>(1, std::min(n_items, max_threads(n_threads)))),
+        ranges(new Range[n_workers]) {
+    for (auto worker = 0u; worker < n_workers; worker++)
+      ranges[worker].bounds.store(pack(n_items * worker / n_workers, n_items * (worker + 1) / n_workers));
+  }
+
+  inline size_t workers() const { return n_workers; }
+
+  // Next item of worker, stolen from another worker if its own range is over. It returns false when no item is left.
+  inline bool next(const size_t worker, size_t &item) {
+    if (cancelled.load(std::memory_order_relaxed)) return false;
+
+    Range &own = ranges[worker];
+    uint64_t bounds = own.bounds.load();
+    while (begin(bounds) < end(bounds))
+      if (own.bounds.compare_exchange_weak(bounds, pack(begin(bounds) + 1, end(bounds)))) {
+        item = begin(bounds);
+        return true;
+      }
+
+    for (auto i = 1u; i < n_workers; i++) {
+      Range &victim = ranges[(worker + i) % n_workers];
+      bounds = victim.bounds.load();
+      while (begin(bounds) < end(bounds)) {
+        const uint64_t middle = end(bounds) - (end(bounds) - begin(bounds) + 1) / 2;
+        if (victim.bounds.compare_exchange_weak(bounds, pack(begin(bounds), middle))) {
+          item = middle;
+          own.bounds.store(pack(middle + 1, end(bounds)));  // own range is empty, so nobody else writes it
+          return true;
+        }
+      }
+    }
+
+    return false;
+  }
+
+  // Runs worker(i) for each worker i on its own thread, returning when all of them are done. When a worker throws,
+  // the others stop taking items and the first exception is rethrown.
+  template <class Worker>
+  inline void run(const Worker &worker) {
+#ifdef MULTITHREADING
+    std::vector<std::thread> threads;
+    threads.reserve(n_workers - 1);
+    for (auto i = 1u; i < n_workers; i++) {
+      try {
+        threads.emplace_back([this, &worker, i] { call(worker, i); });
+      } catch (const std::system_error &) {  // the range of a worker which can't be started is stolen by the others
+        break;
+      }
+    }
+    call(worker, 0);
+    for (auto &thread : threads) thread.join();
+#else
+    call(worker, 0);
+#endif
+
+    if (error) std::rethrow_exception(error);
+  }
+
+ private:
+  struct Range {
+    std::atomic<uint64_t> bounds;  // first item in the low 32 bits, end of the range in the high 32 bits
+    char padding[CACHE_LINE - sizeof(std::atomic<uint64_t>)];
+  };
+
+  size_t n_workers;
+  std::unique_ptr<Range[]> ranges;
+  std::atomic<bool> cancelled{false};
+  std::exception_ptr error;  // first exception thrown by a worker
+#ifdef MULTITHREADING
+  std::mutex mutex;  // guards error
+#endif
+
+  inline static uint64_t pack(const uint64_t begin, const uint64_t end) { return end << 32 | begin; }
+
+  inline static uint64_t begin(const uint64_t bounds) { return bounds & 0xFFFFFFFF; }
+
+  inline static uint64_t end(const uint64_t bounds) { return bounds >> 32; }
+
+  inline static size_t max_threads(const size_t n_threads) {
+#ifdef MULTITHREADING
+    return n_threads != 0 ? n_threads : std::max<size_t>(1, std::thread::hardware_concurrency());
+#else
+    return 1;
+#endif
+  }
+
+  template <class Worker>
+  inline void call(const Worker &worker, const size_t i) {
+    try {
+      worker(i);
+    } catch (...) {
+      cancelled.store(true, std::memory_order_relaxed);
+#ifdef MULTITHREADING
+      std::lock_guard<std::mutex> lock(mutex);
+#endif
+      if (!error) error = std::current_exception();
+    }
+  }
+};
+
+#endif
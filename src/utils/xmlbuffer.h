@@ -0,0 +1,101 @@
+
+/*******************************************************************************
+ * Copyright 2019 AMADEUS. All rights reserved.
+ * Author: Paolo Iannino
+ *******************************************************************************/
+
+#ifndef CPMML_XMLBUFFER_H
+#define CPMML_XMLBUFFER_H
+
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cPMML.h"
+#include "mappedfile.h"
+#include "miniz/miniz.h"
+#include "utils.h"
+
+/**
+ * Buffer holding a PMML document, null-terminated and writable so that rapidxml
+ * can parse it in place: either a copy-on-write mapping of the file, or a
+ * buffer on the heap.
+ */
+class XmlBuffer {
+ public:
+  XmlBuffer() = default;
+
+  explicit XmlBuffer(std::vector<char> buffer) : buffer(std::move(buffer)) {}
+
+  explicit XmlBuffer(std::unique_ptr<MappedFile> file) : file(std::move(file)) {}
+
+  // Copy of the size bytes at data, null-terminated
+  XmlBuffer(const char *data, const size_t size) : buffer(size + 1, '\0') {
+    std::copy(data, data + size, buffer.begin());
+  }
+
+  inline char *data() { return file ? file->data() : buffer.data(); }
+
+ private:
+  std::vector<char> buffer;
+  std::unique_ptr<MappedFile> file;
+};
+
+static inline XmlBuffer read_xml(const std::string &filepath) {
+  std::unique_ptr<MappedFile> file(new MappedFile(filepath, MappedFile::Access::COPY_ON_WRITE));
+  if (file->null_terminated()) return XmlBuffer(std::move(file));
+
+  return XmlBuffer(file->data(), file->size());  // the file fills its last page, leaving no room for the terminator
+}
+
+static inline void mz_reader_error(mz_zip_archive *zip_archive, const std::string &message) {
+  mz_zip_reader_end(zip_archive);
+  throw cpmml::ParsingException("unzip - err: " + message);
+}
+
+// The first file of the zip archive of size bytes at data, inflated straight into the buffer to be parsed
+static inline XmlBuffer read_zip(const char *data, const size_t size) {
+  mz_zip_archive zip_archive;
+  mz_zip_archive_file_stat file_stat;
+
+  memset(&zip_archive, 0, sizeof(zip_archive));
+  if (!mz_zip_reader_init_mem(&zip_archive, data, size, 0))
+    throw cpmml::ParsingException("unzip - err: reading archive");
+  if (mz_zip_reader_get_num_files(&zip_archive) < 1) mz_reader_error(&zip_archive, "no file in archive");
+  if (mz_zip_reader_is_file_a_directory(&zip_archive, 0)) mz_reader_error(&zip_archive, "directory in archive");
+  if (!mz_zip_reader_file_stat(&zip_archive, 0, &file_stat) ||
+      file_stat.m_uncomp_size >= std::numeric_limits<size_t>::max())
+    mz_reader_error(&zip_archive, "reading file size");
+
+  std::vector<char> buffer(static_cast<size_t>(file_stat.m_uncomp_size) + 1, '\0');
+  if (!mz_zip_reader_extract_to_mem(&zip_archive, 0, buffer.data(), buffer.size() - 1, 0))
+    mz_reader_error(&zip_archive, "decompressing");
+  mz_zip_reader_end(&zip_archive);
+
+  return XmlBuffer(std::move(buffer));
+}
+
+static inline XmlBuffer read_zip(const std::string &filepath) {
+  MappedFile file(filepath);
+
+  return read_zip(file.data(), file.size());
+}
+
+static inline XmlBuffer read_file(const std::string &filepath, const bool zipped) {
+  if (!file_exists(filepath)) throw cpmml::ParsingException("Input file " + filepath + " does not exist");
+
+  if (zipped) return read_zip(filepath);
+
+  return read_xml(filepath);
+}
+
+// As read_file, for a document of size bytes at data
+static inline XmlBuffer read_buffer(const char *data, const size_t size, const bool zipped) {
+  if (zipped) return read_zip(data, size);
+
+  return XmlBuffer(data, size);
+}
+
+#endif
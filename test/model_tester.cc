@@ -4,10 +4,18 @@
  * Author: Paolo Iannino
  *******************************************************************************/
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "cPMML.h"
+#include "core/modelbuilder.h"
 #include "utils/csvreader.h"
 #include "utils/utils.h"
 
@@ -22,10 +30,260 @@ inline double regression_error(const cpmml::Prediction &prediction,
   return 0.0;
 }
 
+inline bool is_numeric(const std::vector<std::unordered_map<std::string, std::string>> &samples,
+                       const std::string &column) {
+  for (const auto &sample : samples) {
+    try {
+      if (!sample.at(column).empty()) to_double(sample.at(column));
+    } catch (const cpmml::ParsingException &exception) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// columns made only of numbers are passed as numeric columns, empty values being missing,
+// all the others are dictionary encoded
+struct BatchColumns {
+  std::vector<std::vector<double>> values;
+  std::vector<std::vector<uint8_t>> missing;
+  std::vector<std::vector<int32_t>> codes;
+};
+
+inline cpmml::Batch to_batch(const std::vector<std::unordered_map<std::string, std::string>> &samples,
+                             BatchColumns &columns) {
+  cpmml::Batch batch(samples.size());
+  for (const auto &field : samples[0]) {
+    const std::string &column = field.first;
+    if (column == "prediction") continue;
+
+    if (is_numeric(samples, column)) {
+      columns.values.push_back(std::vector<double>(samples.size(), 0));
+      columns.missing.push_back(std::vector<uint8_t>(samples.size() / 8 + 1, 0));
+      for (auto row = 0u; row < samples.size(); row++) {
+        if (samples[row].at(column).empty())
+          columns.missing.back()[row / 8] |= 1 << (row % 8);
+        else
+          columns.values.back()[row] = to_double(samples[row].at(column));
+      }
+      batch.add_numeric(column, columns.values.back().data(), columns.missing.back().data());
+    } else {
+      std::unordered_map<std::string, int32_t> codes;
+      std::vector<std::string> dictionary;
+      columns.codes.push_back(std::vector<int32_t>(samples.size(), 0));
+      for (auto row = 0u; row < samples.size(); row++) {
+        auto code = codes.insert(std::make_pair(samples[row].at(column), int32_t(dictionary.size())));
+        if (code.second) dictionary.push_back(samples[row].at(column));
+        columns.codes.back()[row] = code.first->second;
+      }
+      batch.add_categorical(column, columns.codes.back().data(), dictionary);
+    }
+  }
+
+  return batch;
+}
+
+inline int test_batch(const cpmml::Model &model,
+                      const std::vector<std::unordered_map<std::string, std::string>> &samples) {
+  BatchColumns columns;
+  columns.values.reserve(samples[0].size());
+  columns.missing.reserve(samples[0].size());
+  columns.codes.reserve(samples[0].size());
+  cpmml::Batch batch = to_batch(samples, columns);
+  std::vector<std::string> predictions(samples.size());
+  std::vector<double> double_predictions(samples.size());
+
+  std::vector<std::string> parallel_predictions(samples.size());
+  std::vector<double> parallel_double_predictions(samples.size());
+
+  model.score_batch(batch, predictions.data());
+  model.score_batch(batch, double_predictions.data());
+  model.score_batch_parallel(batch, parallel_predictions.data(), 3);
+  model.score_batch_parallel(batch, parallel_double_predictions.data(), 3);
+  if (parallel_predictions != predictions or
+      !std::equal(double_predictions.cbegin(), double_predictions.cend(), parallel_double_predictions.cbegin(),
+                  [](const double a, const double b) { return a == b or (std::isnan(a) and std::isnan(b)); })) {
+    std::cerr << "parallel batch predictions differ from batch predictions" << std::endl;
+    return -1;
+  }
+  for (auto row = 0u; row < samples.size(); row++) {
+    // string predictions must be the ones of predict, double predictions the ones of score up to the tolerance
+    const std::string predicted = model.predict(samples[row]);
+    cpmml::Prediction prediction = model.score(samples[row]);
+    if (predictions[row] != predicted or
+        (double_predictions[row] != prediction.as_double() and
+         std::abs(double_predictions[row] - prediction.as_double()) >=
+             std::abs(prediction.as_double()) * regression_relative_error_tolerance)) {
+      std::cerr << "batch predicted: " << predictions[row] << " (" << double_predictions[row]
+                << ") predicted: " << predicted << " (" << prediction.as_double()
+                << ") sample: " << to_string(samples[row]) << std::endl;
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+inline int test_input(const cpmml::Model &model, const std::unordered_map<std::string, std::string> &sample,
+                      cpmml::Input &input, cpmml::ScoringContext &context) {
+  input.clear();
+  for (const auto &field : sample) {
+    if (field.first == "prediction") continue;
+    try {
+      input.set(model.get_handle(field.first), field.second);
+    } catch (const cpmml::InvalidValueException &exception) {  // field not used by the model
+    }
+  }
+
+  if (model.predict(input) != model.predict(sample) or model.predict(input, context) != model.predict(sample)) {
+    std::cerr << "input predicted: " << model.predict(input) << " predicted: " << model.predict(sample)
+              << " sample: " << to_string(sample) << std::endl;
+    return -1;
+  }
+
+  cpmml::Prediction prediction = model.score(sample);
+  double predicted_double = model.predict_double(input, context);
+  if (predicted_double != prediction.as_double() and
+      std::abs(predicted_double - prediction.as_double()) >=
+          std::abs(prediction.as_double()) * regression_relative_error_tolerance) {
+    std::cerr << "double predicted: " << predicted_double << " predicted: " << prediction.as_double()
+              << " sample: " << to_string(sample) << std::endl;
+    return -1;
+  }
+
+  if (!model.classes().empty()) {
+    int class_index = model.predict_class_index(input, context);
+    if ((class_index < 0 ? std::string() : model.classes()[class_index]) != prediction.as_string()) {
+      std::cerr << "class predicted: " << class_index << " predicted: " << prediction.as_string()
+                << " sample: " << to_string(sample) << std::endl;
+      return -1;
+    }
+  }
+
+  cpmml::Prediction try_prediction;
+  std::string try_predicted;
+  if (!model.try_score(input, try_prediction).ok() or try_prediction.as_string() != prediction.as_string() or
+      !model.try_predict(sample, try_predicted).ok() or try_predicted != model.predict(sample)) {
+    std::cerr << "try predicted: " << try_predicted << " predicted: " << prediction.as_string()
+              << " sample: " << to_string(sample) << std::endl;
+    return -1;
+  }
+
+  std::future<cpmml::Prediction> async_prediction = model.score_async(input);
+  std::future<std::string> async_predicted = model.predict_async(input);
+  if (async_prediction.get().as_string() != prediction.as_string() or async_predicted.get() != model.predict(sample)) {
+    std::cerr << "async prediction differs from prediction: " << prediction.as_string()
+              << " sample: " << to_string(sample) << std::endl;
+    return -1;
+  }
+
+  cpmml::Prediction context_prediction = model.score(input, context);
+  if (context_prediction.as_string() != prediction.as_string() or
+      context_prediction.distribution() != prediction.distribution() or
+      context_prediction.num_outputs() != prediction.num_outputs() or
+      context_prediction.str_outputs() != prediction.str_outputs()) {
+    std::cerr << "context predicted: " << context_prediction.as_string() << " predicted: " << prediction.as_string()
+              << " sample: " << to_string(sample) << std::endl;
+    return -1;
+  }
+
+  const std::vector<std::pair<size_t, double>> top = prediction.top_k(1);
+  for (const auto &probability : prediction.distribution())
+    if (top.empty() or probability.second > top[0].second or
+        prediction.distribution().at(prediction.labels()[top[0].first]) != top[0].second) {
+      std::cerr << "top probability: " << (top.empty() ? 0 : top[0].second) << " sample: " << to_string(sample)
+                << std::endl;
+      return -1;
+    }
+
+  return 0;
+}
+
+// The same model is scored from several threads at once, each with its own input and context
+inline int test_concurrent(const cpmml::Model &model,
+                           const std::vector<std::unordered_map<std::string, std::string>> &samples) {
+  const unsigned n_threads = 4;
+  std::vector<std::string> expected;
+  for (const auto &sample : samples) expected.push_back(model.predict(sample));
+
+  std::vector<int> errors(n_threads, 0);
+  std::vector<std::thread> threads;
+  for (auto t = 0u; t < n_threads; t++)
+    threads.emplace_back([&, t]() {
+      cpmml::Input input;
+      cpmml::ScoringContext context;
+      for (auto row = t; row < t + samples.size(); row++) {
+        const auto &sample = samples[row % samples.size()];
+        const std::string &predicted = expected[row % samples.size()];
+        input.clear();
+        for (const auto &field : sample) {
+          if (field.first == "prediction") continue;
+          try {
+            input.set(model.get_handle(field.first), field.second);
+          } catch (const cpmml::InvalidValueException &exception) {  // field not used by the model
+          }
+        }
+
+        if (model.predict(sample) != predicted or model.predict(input, context) != predicted or
+            model.score(input).as_string() != model.score(sample).as_string() or
+            model.validate(input) != model.validate(sample))
+          errors[t]++;
+      }
+    });
+  for (auto &thread : threads) thread.join();
+
+  for (auto t = 0u; t < n_threads; t++)
+    if (errors[t] != 0) {
+      std::cerr << "concurrent predictions differ from predictions: " << errors[t] << " in thread " << t << std::endl;
+      return -1;
+    }
+
+  return 0;
+}
+
+// The model loaded from its snapshot must predict as the one loaded from the PMML file
+inline int test_snapshot(const cpmml::Model &model, const std::string &model_filepath,
+                         const std::vector<std::unordered_map<std::string, std::string>> &samples) {
+  const std::string snapshot_filepath = model_filepath + ".snapshot";
+  ModelBuilder::compile(model_filepath, true, snapshot_filepath);
+  std::unique_ptr<InternalEvaluator> snapshot_model = ModelBuilder::build_from_snapshot(snapshot_filepath);
+  std::remove(snapshot_filepath.c_str());
+
+  for (const auto &sample : samples)
+    if (snapshot_model->predict(sample) != model.predict(sample)) {
+      std::cerr << "snapshot predicted: " << snapshot_model->predict(sample) << " predicted: " << model.predict(sample)
+                << " sample: " << to_string(sample) << std::endl;
+      return -1;
+    }
+
+  return 0;
+}
+
+// The model loaded from a buffer in memory must predict as the one loaded from the file
+inline int test_buffer(const cpmml::Model &model, const std::string &model_filepath,
+                       const std::vector<std::unordered_map<std::string, std::string>> &samples) {
+  std::ifstream file(model_filepath, std::ios::binary);
+  const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  cpmml::Model buffer_model(data.data(), data.size(), true);
+
+  for (const auto &sample : samples)
+    if (buffer_model.predict(sample) != model.predict(sample)) {
+      std::cerr << "buffer predicted: " << buffer_model.predict(sample) << " predicted: " << model.predict(sample)
+                << " sample: " << to_string(sample) << std::endl;
+      return -1;
+    }
+
+  return 0;
+}
+
 int main(int argc, char **argv) {
   cpmml::Model model(argv[1], true);
   CSVReader reader(argv[2]);
   std::unordered_map<std::string, std::string> sample;
+  std::vector<std::unordered_map<std::string, std::string>> samples;
+  cpmml::Input input;
+  cpmml::ScoringContext context;
 
   while ((sample = reader.read()).size() > 0) {
     cpmml::Prediction prediction = model.score(sample);
@@ -35,7 +293,14 @@ int main(int argc, char **argv) {
       std::cerr << " true: " << sample["prediction"] << " sample: " << to_string(sample) << std::endl;
       return -1;
     }
+    if (test_input(model, sample, input, context) != 0) return -1;
+    samples.push_back(sample);
   }
 
+  if (!samples.empty() and test_concurrent(model, samples) != 0) return -1;
+  if (!samples.empty() and test_snapshot(model, argv[1], samples) != 0) return -1;
+  if (!samples.empty() and test_buffer(model, argv[1], samples) != 0) return -1;
+  if (!samples.empty()) return test_batch(model, samples);
+
   return 0;
 }